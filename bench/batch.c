@@ -0,0 +1,184 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Render 512 random poses with batch_render at 84x84 and 160x120 on both test
+ * maps, with one worker per processor, and compare each frame and depth
+ * buffer with rendering the same poses one after the other with
+ * raycaster_render_world. Prints the frames per second and per core of
+ * both. batch_init must also refuse a streamed map. */
+
+#include <bench.h>
+#include <batch.h>
+#include <testmap.h>
+#include <spritemap.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define POSES 512
+
+/* Each benchmark is run RUNS times and the fastest run is kept. */
+#define RUNS 3
+
+typedef struct {
+    int width, height;
+} Size;
+
+Size _sizes[] = {
+    {84, 84},
+    {160, 120}
+};
+
+Pose _poses[POSES];
+BatchFrame _frames[POSES];
+BatchFrame _reference[POSES];
+
+/* Place the poses on random empty cells of map. */
+void _init_poses(Map *map) {
+    int i;
+    srand(1);
+    for(i=0;i<POSES;i++){
+        do{
+            _poses[i].x = rand()%(map->width*128)*TO_FIXED(1)/128;
+            _poses[i].y = rand()%(map->height*128)*TO_FIXED(1)/128;
+        }while(MAP_TILE(map, TO_INT(_poses[i].x), TO_INT(_poses[i].y)));
+        _poses[i].r = TO_FIXED(rand()%360);
+    }
+}
+
+void _alloc_frames(BatchFrame *frames, int width, int height) {
+    int i;
+    for(i=0;i<POSES;i++){
+        frames[i].pixels = malloc(width*height*sizeof(Pixel));
+        frames[i].depth = malloc(width*sizeof(fixed_t));
+        if(!frames[i].pixels || !frames[i].depth){
+            fputs("[batch] Failed to allocate the frames!\n", stderr);
+            exit(-1);
+        }
+    }
+}
+
+void _free_frames(BatchFrame *frames) {
+    int i;
+    for(i=0;i<POSES;i++){
+        free(frames[i].pixels);
+        free(frames[i].depth);
+    }
+}
+
+/* Render the poses one after the other into _reference. Returns the time it
+ * took in microseconds. */
+unsigned long _render_sequential(Map *map, int width, int height) {
+    Raycaster r;
+    Renderer target;
+    int i;
+    unsigned long start;
+    render_init_pixels(&target, NULL, width, height);
+    raycaster_init_target(&r, &target, map, 0, 0, 0, _reference[0].depth);
+    /* Like the batch, which renders unrelated frames. */
+    r.incremental = 0;
+    r.reuse_rays = 0;
+    r.target_ms = 0;
+    start = bench_us();
+    for(i=0;i<POSES;i++){
+        render_init_pixels(&target, _reference[i].pixels, width, height);
+        r.zbuffer = _reference[i].depth;
+        r.x = _poses[i].x;
+        r.y = _poses[i].y;
+        r.r = _poses[i].r;
+        raycaster_render_world(&r);
+    }
+    start = bench_us()-start;
+    raycaster_free(&r);
+    return start;
+}
+
+/* Returns the number of frames that differ from the sequential render. */
+int _run(Map *map, char *name, int width, int height) {
+    Batch batch;
+    int i, run, cores, differ = 0;
+    unsigned long start, us, batch_us = -1UL, sequential_us = -1UL;
+    _init_poses(map);
+    _alloc_frames(_frames, width, height);
+    _alloc_frames(_reference, width, height);
+    if(batch_init(&batch, map, width, height, 0)) exit(-1);
+    for(run=0;run<RUNS;run++){
+        us = _render_sequential(map, width, height);
+        if(us < sequential_us) sequential_us = us;
+        start = bench_us();
+        batch_render(&batch, _poses, _frames, POSES);
+        us = bench_us()-start;
+        if(us < batch_us) batch_us = us;
+    }
+    for(i=0;i<POSES;i++){
+        differ += memcmp(_frames[i].pixels, _reference[i].pixels,
+                         width*height*sizeof(Pixel)) ||
+                  memcmp(_frames[i].depth, _reference[i].depth,
+                         width*sizeof(fixed_t));
+    }
+    cores = bench_cores();
+    if(cores > batch.worker_num) cores = batch.worker_num;
+    printf("%s %dx%d: batch_render %.0f frames/s with %d workers (%.0f per "
+           "core), raycaster_render_world %.0f frames/s, %d frames differ\n",
+           name, width, height, POSES*1000000.0/batch_us, batch.worker_num,
+           POSES*1000000.0/batch_us/cores, POSES*1000000.0/sequential_us,
+           differ);
+    batch_free(&batch);
+    _free_frames(_frames);
+    _free_frames(_reference);
+    return differ;
+}
+
+int main(void) {
+    Map streamed;
+    Batch batch;
+    unsigned int i;
+    int differ = 0;
+    for(i=0;i<sizeof(_sizes)/sizeof(_sizes[0]);i++){
+        differ += _run(&testmap, "testmap", _sizes[i].width,
+                       _sizes[i].height);
+        differ += _run(&spritemap, "spritemap", _sizes[i].width,
+                       _sizes[i].height);
+    }
+    /* A streamed map has no data. */
+    streamed = testmap;
+    streamed.data = NULL;
+    if(!batch_init(&batch, &streamed, 84, 84, 1)){
+        puts("batch_init accepted a streamed map!");
+        batch_free(&batch);
+        differ++;
+    }
+    return differ != 0;
+}
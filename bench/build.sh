@@ -0,0 +1,58 @@
+#!/bin/sh
+# Build the benchmarks and the checks of bench/, to be run from the root of the
+# repository. They use the SDL2 platform, drawing into framebuffers without
+# opening any window.
+
+out=bench/build
+
+# The sources of build.sh but main.c.
+src="platforms/sdl2/render.c src/fixed.c src/raycaster.c src/map.c \
+     src/profile.c src/mapfile.c src/chunkmap.c src/texpack.c \
+     src/hotreload.c src/batch.c src/los.c src/entity.c src/flowfield.c \
+     src/pipeline.c src/jobs.c src/arena.c src/perfcount.c bench/bench.c \
+     $out/wall.c $out/wood.c $out/sprite.c $out/testmap.c $out/spritemap.c"
+
+mkdir -p $out
+
+for i in wall wood sprite; do
+    python3 src/texgen.py assets/$i.png $out/$i.c $out/$i.h
+done
+
+python3 src/mapgen.py assets/testmap.png assets/testmap.json $out/testmap.c \
+        $out/testmap.h
+python3 src/mapgen.py assets/spritemap.png assets/spritemap.json \
+        $out/spritemap.c $out/spritemap.h
+
+flags="-Wall -Wextra -Wpedantic -O2 -g -ansi -Isrc -Iplatforms/sdl2 -Ibench \
+       -I$out"
+libs="-lSDL2 -lm -lpthread"
+
+# Compile the sources into the directory $1 with the extra flags $2, the
+# objects being listed in obj.
+compile() {
+    mkdir -p $1
+    obj=""
+    for i in $src; do
+        cc -c $i -o $1/$(basename $i .c).o $flags $2 || exit 1
+        obj="$obj $1/$(basename $i .c).o"
+    done
+}
+
+compile $out/obj ""
+
+for i in spans sprites reuse threads scan los entity flowfield heap pipeline batch gbuffer; do
+    cc bench/$i.c $obj -o $out/$i $flags $libs || exit 1
+done
+
+# spans without the SSE2 kernel of render_hspan.
+cc -c platforms/sdl2/render.c -o $out/render_scalar.o $flags -U__SSE2__ || \
+   exit 1
+cc bench/spans.c $(echo $obj | sed "s|$out/obj/render.o|$out/render_scalar.o|") \
+   -o $out/spans_scalar $flags -U__SSE2__ $libs || exit 1
+
+# threads and pipeline with ThreadSanitizer.
+compile $out/tsan "-fsanitize=thread"
+for i in threads pipeline; do
+    cc bench/$i.c $obj -o $out/${i}_tsan $flags -fsanitize=thread $libs || \
+       exit 1
+done
@@ -0,0 +1,163 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Time entities_update with 50000 entities on a random map, walking at 3 and
+ * at 40 cells per second in random directions, each one picking a new
+ * direction when a wall stops it. The entities must never overlap a wall by
+ * more than the rounding of the fixed point numbers, and their sprites must
+ * follow them. */
+
+#include <bench.h>
+#include <entity.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WIDTH 512
+#define HEIGHT 512
+/* The percentage of walls. */
+#define WALLS 20
+
+#define ENTITIES 50000
+
+/* The largest overlap allowed between an entity and a wall, in cells. */
+#define TOLERANCE 0.001
+
+/* The overlap is checked every CHECK_STEP ticks. */
+#define CHECK_STEP 10
+
+unsigned char _data[WIDTH*HEIGHT];
+Tile _tileset[2];
+Map _map;
+Sprite _sprites[ENTITIES];
+
+typedef struct {
+    char *name;
+    int speed; /* In cells per second. */
+    int ticks;
+} Run;
+
+Run _runs[] = {
+    {"3 cells/s", 3, 300},
+    {"40 cells/s", 40, 100}
+};
+
+char _solid(int x, int y) {
+    return x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT ||
+           MAP_TILE(&_map, x, y);
+}
+
+/* How deep the entity i is in the walls around it, in cells. */
+double _overlap(Entities *e, int i) {
+    double x = (double)e->x[i]/TO_FIXED(1);
+    double y = (double)e->y[i]/TO_FIXED(1);
+    double r = (double)e->radius[i]/TO_FIXED(1);
+    double nx, ny, d, worst = 0;
+    int cx, cy;
+    for(cy=(int)floor(y-r);cy<=(int)floor(y+r);cy++){
+        for(cx=(int)floor(x-r);cx<=(int)floor(x+r);cx++){
+            if(!_solid(cx, cy)) continue;
+            /* The point of the cell closest to the center. */
+            nx = x < cx ? cx : x > cx+1 ? cx+1 : x;
+            ny = y < cy ? cy : y > cy+1 ? cy+1 : y;
+            d = r-sqrt((x-nx)*(x-nx)+(y-ny)*(y-ny));
+            if(d > worst) worst = d;
+        }
+    }
+    return worst;
+}
+
+/* Run the ticks of run, printing the time per tick. Returns the largest
+ * overlap with a wall. */
+double _run(Entities *e, Run *run) {
+    int i, k;
+    fixed_t a;
+    fixed_t dt = TO_FIXED(1)/60;
+    double overlap, worst = 0;
+    unsigned long start, us = 0;
+    for(k=0;k<run->ticks;k++){
+        for(i=0;i<e->num;i++){
+            if(!e->vx[i] && !e->vy[i]){
+                a = TO_FIXED(rand()%360);
+                e->vx[i] = DCOS(a)*run->speed;
+                e->vy[i] = DSIN(a)*run->speed;
+            }
+        }
+        start = bench_us();
+        entities_update(e, &_map, dt);
+        us += bench_us()-start;
+        if(k%CHECK_STEP) continue;
+        for(i=0;i<e->num;i++){
+            overlap = _overlap(e, i);
+            if(overlap > worst) worst = overlap;
+        }
+    }
+    printf("%s: %d entities, %.3f ms per tick, overlapping the walls by up "
+           "to %.5f cells\n", run->name, e->num, us/1000.0/run->ticks, worst);
+    return worst;
+}
+
+int main(void) {
+    Entities e;
+    unsigned int i;
+    int x, y;
+    double worst = 0, overlap;
+    int out_of_sync = 0;
+    srand(5);
+    for(i=0;i<WIDTH*HEIGHT;i++) _data[i] = rand()%100 < WALLS;
+    _map.data = _data;
+    _map.width = WIDTH;
+    _map.height = HEIGHT;
+    _map.tileset = _tileset;
+    entities_init(&e, ENTITIES);
+    for(i=0;i<ENTITIES;i++){
+        do{
+            x = rand()%WIDTH;
+            y = rand()%HEIGHT;
+        }while(_solid(x, y));
+        entities_add(&e, TO_FIXED(x)+TO_FIXED(0.5), TO_FIXED(y)+TO_FIXED(0.5),
+                     TO_FIXED(0.1)+rand()%30*TO_FIXED(1)/100, _sprites+i);
+    }
+    for(i=0;i<sizeof(_runs)/sizeof(_runs[0]);i++){
+        overlap = _run(&e, _runs+i);
+        if(overlap > worst) worst = overlap;
+    }
+    for(i=0;i<ENTITIES;i++){
+        out_of_sync += _sprites[i].x != e.x[i] || _sprites[i].y != e.y[i];
+    }
+    printf("%d sprites out of sync\n", out_of_sync);
+    entities_free(&e);
+    return worst > TOLERANCE || out_of_sync;
+}
@@ -0,0 +1,164 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Time building a flow field and updating it after a tile changed, on random
+ * maps of 256x256 and 2048x2048 cells with 20% of walls and 1 then 4 goals.
+ * After each change, the field must be the same as a field rebuilt from
+ * scratch (only after the first few ones on the big map, as rebuilding it
+ * takes a while), and each direction must lead to a neighbor closer to a
+ * goal. */
+
+#include <bench.h>
+#include <flowfield.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The percentage of walls. */
+#define WALLS 20
+#define GOALS 4
+
+typedef struct {
+    int size;
+    int changes;
+    /* How many changes are checked against a rebuild. */
+    int checked;
+} Run;
+
+Run _runs[] = {
+    {256, 500, 500},
+    {2048, 200, 3}
+};
+
+Tile _tileset[2];
+
+/* The number of cells of field whose direction doesn't lead to a neighbor
+ * closer to a goal, by the cost of the move. */
+int _invalid(FlowField *field) {
+    static const int dx[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+    static const int dy[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+    int x, y, cell, next, dir;
+    int invalid = 0;
+    for(y=0;y<field->height;y++){
+        for(x=0;x<field->width;x++){
+            cell = y*field->width+x;
+            dir = field->dir[cell];
+            if(field->dist[cell] == FLOW_UNREACHABLE || !field->dist[cell]){
+                invalid += dir != FLOW_NONE;
+                continue;
+            }
+            if(dir == FLOW_NONE){
+                invalid++;
+                continue;
+            }
+            next = cell+dy[dir]*field->width+dx[dir];
+            invalid += field->dist[next]+(dir&1 ? FLOW_DIAGONAL :
+                                          FLOW_STRAIGHT) != field->dist[cell];
+        }
+    }
+    return invalid;
+}
+
+/* Returns the number of fields that were wrong. */
+int _run(Run *run) {
+    int size = run->size;
+    Map map;
+    FlowField field, ref;
+    int goals_x[GOALS], goals_y[GOALS];
+    int i, x, y;
+    int wrong = 0, reachable = 0;
+    unsigned long start, build_us, update_us = 0, rebuild_us = 0;
+    memset(&map, 0, sizeof(map));
+    map.data = malloc(size*size);
+    if(!map.data){
+        fputs("[flowfield] Failed to allocate the map!\n", stderr);
+        exit(-1);
+    }
+    map.width = size;
+    map.height = size;
+    map.tileset = _tileset;
+    srand(size);
+    for(i=0;i<size*size;i++) map.data[i] = rand()%100 < WALLS;
+    for(i=0;i<GOALS;i++){
+        goals_x[i] = rand()%size;
+        goals_y[i] = rand()%size;
+        map.data[goals_y[i]*size+goals_x[i]] = 0;
+    }
+    flowfield_init(&field, &map);
+    flowfield_init(&ref, &map);
+    start = bench_us();
+    flowfield_build(&field, goals_x, goals_y, 1);
+    build_us = bench_us()-start;
+    for(i=0;i<size*size;i++) reachable += field.dist[i] != FLOW_UNREACHABLE;
+    wrong += _invalid(&field) != 0;
+    printf("%dx%d, 1 goal: build %.2f ms, %d reachable cells\n", size, size,
+           build_us/1000.0, reachable);
+    start = bench_us();
+    flowfield_build(&field, goals_x, goals_y, GOALS);
+    build_us = bench_us()-start;
+    wrong += _invalid(&field) != 0;
+    printf("%dx%d, %d goals: build %.2f ms\n", size, size, GOALS,
+           build_us/1000.0);
+    for(i=0;i<run->changes;i++){
+        x = rand()%size;
+        y = rand()%size;
+        map_set_tile(&map, x, y, !MAP_TILE(&map, x, y));
+        start = bench_us();
+        flowfield_update_tile(&field, x, y);
+        update_us += bench_us()-start;
+        if(i >= run->checked) continue;
+        start = bench_us();
+        flowfield_build(&ref, goals_x, goals_y, GOALS);
+        rebuild_us += bench_us()-start;
+        wrong += memcmp(field.dist, ref.dist,
+                        size*size*sizeof(unsigned int)) != 0 ||
+                 _invalid(&field) != 0;
+    }
+    printf("  %d tile changes: %.3f ms per update, %.2f ms per rebuild\n",
+           run->changes, update_us/1000.0/run->changes,
+           rebuild_us/1000.0/run->checked);
+    flowfield_free(&field);
+    flowfield_free(&ref);
+    free(map.data);
+    return wrong;
+}
+
+int main(void) {
+    unsigned int i;
+    int wrong = 0;
+    for(i=0;i<sizeof(_runs)/sizeof(_runs[0]);i++) wrong += _run(_runs+i);
+    printf("%d wrong fields\n", wrong);
+    return wrong != 0;
+}
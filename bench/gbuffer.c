@@ -0,0 +1,174 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Render views of the test map three ways: without a G-buffer, with one and
+ * with one in no_color mode. The colors must be the same with and without the
+ * G-buffer, no_color must leave the framebuffer untouched while filling the
+ * z-buffer and the planes like the color rendering, and the planes must hold
+ * the expected tile, face and sprite at a few known pixels. */
+
+#include <bench.h>
+#include <raycaster.h>
+#include <testmap.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define WIDTH 320
+#define HEIGHT 240
+
+/* What no_color must leave in the framebuffer. */
+#define UNTOUCHED 0x55
+
+/* A view and what the center of the screen shows. */
+typedef struct {
+    char *name;
+    fixed_t x, y, r;
+    int tile, face;
+    fixed_t dist, u; /* Of the wall in the center column. */
+    int sprite; /* The sprite plane in the center pixel. */
+} View;
+
+/* The wall tiles are 1 and the wood tiles 2. The sprite 0 is at 1.5, 2.5. */
+View _views[] = {
+    {"west wall", TO_FIXED(5.5), TO_FIXED(4.5), TO_FIXED(180), 1, FACE_EAST,
+     TO_FIXED(4.5), TO_FIXED(0.5), 0},
+    {"wood wall", TO_FIXED(29.5), TO_FIXED(21.5), 0, 2, FACE_WEST,
+     TO_FIXED(1.5), TO_FIXED(0.5), 0},
+    {"north wall", TO_FIXED(4.5), TO_FIXED(4.5), TO_FIXED(270), 1,
+     FACE_SOUTH, TO_FIXED(3.5), TO_FIXED(0.5), 0},
+    {"sprite", TO_FIXED(1.5), TO_FIXED(5.5), TO_FIXED(270), 1, FACE_SOUTH,
+     TO_FIXED(4.5), TO_FIXED(0.5), 1}
+};
+
+/* The distances and the texture coordinates are compared up to this. */
+#define TOLERANCE TO_FIXED(0.01)
+
+Pixel _colors[WIDTH*HEIGHT];
+fixed_t _zbuffer[WIDTH];
+fixed_t _colors_zbuffer[WIDTH];
+
+unsigned char _tile[WIDTH];
+unsigned char _face[WIDTH];
+fixed_t _u[WIDTH];
+unsigned short _sprite[WIDTH*HEIGHT];
+
+unsigned char _tile_color[WIDTH];
+unsigned char _face_color[WIDTH];
+fixed_t _u_color[WIDTH];
+unsigned short _sprite_color[WIDTH*HEIGHT];
+
+/* Returns the number of errors of the view. */
+int _check(Raycaster *r, Renderer *target, View *view) {
+    GBuffer g;
+    int i, errors = 0;
+    int x = WIDTH/2;
+    unsigned char *bytes = (unsigned char*)target->pixels;
+    r->x = view->x;
+    r->y = view->y;
+    r->r = view->r;
+    /* Without a G-buffer. */
+    r->gbuffer = NULL;
+    raycaster_render_world(r);
+    memcpy(_colors, target->pixels, sizeof(_colors));
+    memcpy(_colors_zbuffer, _zbuffer, sizeof(_zbuffer));
+    /* With one, the colors must not change. */
+    memset(&g, 0, sizeof(g));
+    g.tile = _tile_color;
+    g.face = _face_color;
+    g.u = _u_color;
+    g.sprite = _sprite_color;
+    r->gbuffer = &g;
+    raycaster_render_world(r);
+    if(memcmp(_colors, target->pixels, sizeof(_colors)) ||
+       memcmp(_colors_zbuffer, _zbuffer, sizeof(_zbuffer))){
+        printf("%s: the G-buffer changed the colors\n", view->name);
+        errors++;
+    }
+    /* Without colors, the framebuffer must not change. */
+    memset(target->pixels, UNTOUCHED, sizeof(_colors));
+    memset(_zbuffer, 0, sizeof(_zbuffer));
+    g.tile = _tile;
+    g.face = _face;
+    g.u = _u;
+    g.sprite = _sprite;
+    g.no_color = 1;
+    raycaster_render_world(r);
+    for(i=0;i<(int)sizeof(_colors);i++){
+        if(bytes[i] != UNTOUCHED){
+            printf("%s: no_color drew at %d, %d\n", view->name,
+                   i/(int)sizeof(Pixel)%WIDTH, i/(int)sizeof(Pixel)/WIDTH);
+            errors++;
+            break;
+        }
+    }
+    if(memcmp(_colors_zbuffer, _zbuffer, sizeof(_zbuffer)) ||
+       memcmp(_tile, _tile_color, sizeof(_tile)) ||
+       memcmp(_face, _face_color, sizeof(_face)) ||
+       memcmp(_u, _u_color, sizeof(_u)) ||
+       memcmp(_sprite, _sprite_color, sizeof(_sprite))){
+        printf("%s: the planes differ without colors\n", view->name);
+        errors++;
+    }
+    /* The known pixels. */
+    if(_tile[x] != view->tile || _face[x] != view->face ||
+       ABS(_zbuffer[x]-view->dist) > TOLERANCE ||
+       ABS(_u[x]-view->u) > TOLERANCE ||
+       _sprite[HEIGHT/2*WIDTH+x] != view->sprite){
+        printf("%s: tile %d, face %d, distance %.3f, u %.3f, sprite %d in "
+               "the center\n", view->name, _tile[x], _face[x],
+               (double)_zbuffer[x]/TO_FIXED(1), (double)_u[x]/TO_FIXED(1),
+               _sprite[HEIGHT/2*WIDTH+x]);
+        errors++;
+    }
+    /* The top row is always ceiling. */
+    for(i=0;i<WIDTH;i++) errors += _sprite[i] != 0;
+    return errors;
+}
+
+int main(void) {
+    Raycaster r;
+    Renderer target;
+    unsigned int i;
+    int errors = 0;
+    render_init_buffer(&target, WIDTH, HEIGHT);
+    raycaster_init_target(&r, &target, &testmap, 0, 0, 0, _zbuffer);
+    for(i=0;i<sizeof(_views)/sizeof(_views[0]);i++){
+        errors += _check(&r, &target, _views+i);
+    }
+    printf("%d views, %d errors\n", i, errors);
+    raycaster_free(&r);
+    render_free_buffer(&target);
+    return errors != 0;
+}
@@ -0,0 +1,161 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Check that rendering doesn't touch the heap once the first frames have
+ * been rendered. malloc, realloc, calloc and free are replaced by versions
+ * counting the calls of the whole process, then each setting renders WARMUP
+ * frames and FRAMES more while the camera turns, moves and stands still and
+ * two sprites move. The program fails if any of these FRAMES frames called
+ * the heap. */
+
+#include <bench.h>
+#include <raycaster.h>
+#include <testmap.h>
+#include <spritemap.h>
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WIDTH 640
+#define HEIGHT 480
+
+#define WARMUP 10
+#define FRAMES 290
+
+#define WORKERS 4
+
+unsigned long _heap_calls = 0;
+
+/* The functions of glibc behind malloc, realloc, calloc and free. */
+void *__libc_malloc(size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_calloc(size_t num, size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(size_t size) {
+    _heap_calls++;
+    return __libc_malloc(size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    _heap_calls++;
+    return __libc_realloc(ptr, size);
+}
+
+void *calloc(size_t num, size_t size) {
+    _heap_calls++;
+    return __libc_calloc(num, size);
+}
+
+void free(void *ptr) {
+    if(ptr) _heap_calls++;
+    __libc_free(ptr);
+}
+
+enum {
+    S_PLAIN,
+    S_ADAPTIVE,
+    S_INCREMENTAL,
+    S_JOBS,
+    S_AMOUNT
+};
+
+char *_settings[S_AMOUNT] = {
+    "plain",
+    "adaptive",
+    "incremental, reusing the rays",
+    "4 workers"
+};
+
+/* Render the frames of a setting on map. Returns the number of heap calls
+ * after the warm-up. */
+unsigned long _render(Map *map, int setting) {
+    Raycaster r;
+    Renderer target;
+    fixed_t zbuffer[WIDTH];
+    JobSystem jobs;
+    int i, k;
+    unsigned long heap_calls = 0;
+    render_init_buffer(&target, WIDTH, HEIGHT);
+    raycaster_init_target(&r, &target, map, TO_FIXED(2.5), TO_FIXED(2.5),
+                          TO_FIXED(45), zbuffer);
+    if(setting == S_ADAPTIVE) r.adaptive = 1;
+    if(setting == S_INCREMENTAL){
+        r.incremental = 1;
+        r.reuse_rays = 1;
+    }
+    if(setting == S_JOBS){
+        if(jobs_init(&jobs, WORKERS)) exit(-1);
+        r.jobs = &jobs;
+        r.strip_width = 32;
+    }
+    for(i=0;i<WARMUP+FRAMES;i++){
+        if(i == WARMUP) heap_calls = _heap_calls;
+        if(i < 100){
+            r.r += TO_FIXED(2);
+        }else if(i < 200){
+            r.x += TO_FIXED(0.01);
+            r.y += TO_FIXED(0.008);
+        }
+        for(k=0;k<map->sprite_num && k<2;k++){
+            map->sprites[k].x += (i%20 < 10 ? 1 : -1)*TO_FIXED(0.05);
+        }
+        raycaster_render_world(&r);
+    }
+    heap_calls = _heap_calls-heap_calls;
+    raycaster_free(&r);
+    if(setting == S_JOBS) jobs_free(&jobs);
+    render_free_buffer(&target);
+    return heap_calls;
+}
+
+int main(void) {
+    Map *maps[2];
+    char *names[2] = {"testmap", "spritemap"};
+    unsigned long heap_calls;
+    int m, setting;
+    int fail = 0;
+    maps[0] = &testmap;
+    maps[1] = &spritemap;
+    for(m=0;m<2;m++){
+        for(setting=0;setting<S_AMOUNT;setting++){
+            heap_calls = _render(maps[m], setting);
+            printf("%s, %s: %lu heap calls in the last %d frames\n",
+                   names[m], _settings[setting], heap_calls, FRAMES);
+            if(heap_calls) fail = 1;
+        }
+    }
+    return fail;
+}
@@ -0,0 +1,209 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Compare the line of sight queries of los_batch, without a cache and with a
+ * cold and a warm cache, with raycaster_raycast, on a random map where 4000
+ * agents look at the agents within 16 cells of them. The answers with a cache
+ * must be the ones without it, and changing a tile must drop them. */
+
+#include <bench.h>
+#include <los.h>
+#include <raycaster.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WIDTH 512
+#define HEIGHT 512
+/* The percentage of walls. */
+#define WALLS 25
+
+#define AGENTS 4000
+#define QUERIES 200000
+/* The agents look at the ones closer than RANGE cells along both axes. */
+#define RANGE 16
+
+/* Each benchmark is run RUNS times and the fastest run is kept. */
+#define RUNS 5
+
+unsigned char _data[WIDTH*HEIGHT];
+Tile _tileset[2];
+Map _map;
+
+LosQuery _queries[QUERIES];
+unsigned char _visible[QUERIES/8+1];
+unsigned char _visible_cache[QUERIES/8+1];
+
+fixed_t _agent_x[AGENTS];
+fixed_t _agent_y[AGENTS];
+
+void _init_map(void) {
+    int i;
+    srand(3);
+    for(i=0;i<WIDTH*HEIGHT;i++) _data[i] = rand()%100 < WALLS;
+    memset(&_map, 0, sizeof(_map));
+    _map.data = _data;
+    _map.width = WIDTH;
+    _map.height = HEIGHT;
+    _map.tileset = _tileset;
+}
+
+/* Place the agents on random empty cells and make each one look at random
+ * agents in range. */
+void _init_queries(void) {
+    int i, n, a, b;
+    for(i=0;i<AGENTS;i++){
+        do{
+            _agent_x[i] = rand()%(WIDTH*64)*TO_FIXED(1)/64;
+            _agent_y[i] = rand()%(HEIGHT*64)*TO_FIXED(1)/64;
+        }while(MAP_TILE(&_map, TO_INT(_agent_x[i]), TO_INT(_agent_y[i])));
+    }
+    for(i=n=0;n<QUERIES;i++){
+        a = i%AGENTS;
+        b = rand()%AGENTS;
+        if(a == b || ABS(_agent_x[a]-_agent_x[b]) >= TO_FIXED(RANGE) ||
+           ABS(_agent_y[a]-_agent_y[b]) >= TO_FIXED(RANGE)){
+            continue;
+        }
+        _queries[n].x1 = _agent_x[a];
+        _queries[n].y1 = _agent_y[a];
+        _queries[n].x2 = _agent_x[b];
+        _queries[n].y2 = _agent_y[b];
+        n++;
+    }
+}
+
+/* Answer the queries with raycaster_raycast: the target is visible if the
+ * ray stops in its cell or beyond it. Returns the number of visible ones. */
+int _raycast_all(Raycaster *r) {
+    int i, visible = 0;
+    fixed_t dx, dy;
+    RayEnd end;
+    for(i=0;i<QUERIES;i++){
+        dx = _queries[i].x2-_queries[i].x1;
+        dy = _queries[i].y2-_queries[i].y1;
+        end = raycaster_raycast(r, _queries[i].x1, _queries[i].y1,
+                                _queries[i].x2, _queries[i].y2);
+        visible += !end.hit || (end.cx == TO_INT(_queries[i].x2) &&
+                                end.cy == TO_INT(_queries[i].y2)) ||
+                   MUL(end.len, end.len) >= MUL(dx, dx)+MUL(dy, dy);
+    }
+    return visible;
+}
+
+int _count(unsigned char *visible) {
+    int i, n = 0;
+    for(i=0;i<QUERIES;i++) n += visible[i/8]>>(i%8)&1;
+    return n;
+}
+
+/* Returns 1 and prints how many answers differ if the answers with the cache
+ * aren't the ones without it. */
+int _differ(unsigned char *cached, unsigned char *uncached) {
+    int i, n = 0;
+    for(i=0;i<QUERIES;i++) n += (cached[i/8]^uncached[i/8])>>(i%8)&1;
+    if(n) printf("%d answers differ with the cache!\n", n);
+    return n != 0;
+}
+
+void _print(char *name, unsigned long us, int visible) {
+    printf("%s: %.2fM queries/s, %d visible\n", name, (double)QUERIES/us,
+           visible);
+}
+
+int main(void) {
+    Raycaster r;
+    Renderer target;
+    fixed_t zbuffer[1];
+    LosCache cache;
+    int run, visible;
+    int x, y;
+    int differ = 0;
+    unsigned long hits, misses;
+    unsigned long start, us;
+    unsigned long raycast_us, batch_us, warm_us, cold_us;
+    _init_map();
+    _init_queries();
+    render_init_buffer(&target, 1, 1);
+    raycaster_init_target(&r, &target, &_map, 0, 0, 0, zbuffer);
+    r.len = RANGE*2;
+    raycast_us = batch_us = warm_us = -1UL;
+    for(run=0;run<RUNS;run++){
+        start = bench_us();
+        visible = _raycast_all(&r);
+        us = bench_us()-start;
+        if(us < raycast_us) raycast_us = us;
+        start = bench_us();
+        los_batch(&_map, _queries, QUERIES, _visible, NULL);
+        us = bench_us()-start;
+        if(us < batch_us) batch_us = us;
+    }
+    _print("raycaster_raycast", raycast_us, visible);
+    _print("los_batch", batch_us, _count(_visible));
+    los_cache_init(&cache, 1<<18);
+    start = bench_us();
+    los_batch(&_map, _queries, QUERIES, _visible_cache, &cache);
+    cold_us = bench_us()-start;
+    _print("los_batch, cold cache", cold_us, _count(_visible_cache));
+    printf("%lu hits, %lu misses\n", cache.hits, cache.misses);
+    differ += _differ(_visible_cache, _visible);
+    hits = cache.hits;
+    misses = cache.misses;
+    for(run=0;run<RUNS;run++){
+        start = bench_us();
+        los_batch(&_map, _queries, QUERIES, _visible_cache, &cache);
+        us = bench_us()-start;
+        if(us < warm_us) warm_us = us;
+    }
+    _print("los_batch, warm cache", warm_us, _count(_visible_cache));
+    printf("%lu hits, %lu misses\n", cache.hits-hits, cache.misses-misses);
+    differ += _differ(_visible_cache, _visible);
+    /* Toggle a cell next to the first agent. */
+    misses = cache.misses;
+    x = TO_INT(_queries[0].x1)+1;
+    y = TO_INT(_queries[0].y1);
+    map_set_tile(&_map, x, y, !MAP_TILE(&_map, x, y));
+    los_batch(&_map, _queries, QUERIES, _visible, NULL);
+    los_batch(&_map, _queries, QUERIES, _visible_cache, &cache);
+    differ += _differ(_visible_cache, _visible);
+    if(cache.misses == misses){
+        puts("The cache was not dropped when a tile changed!");
+        differ = 1;
+    }
+    los_cache_free(&cache);
+    raycaster_free(&r);
+    render_free_buffer(&target);
+    return differ != 0;
+}
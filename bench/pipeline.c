@@ -0,0 +1,218 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Run the frames of a small game through pipeline_run in each mode and report
+ * the frame rate and the latency. The simulation moves 64 sprites on the
+ * test map and 20000 entities on another map, the rendering draws the test
+ * map at 320x240 and present hashes the frame. It is run once as fast as
+ * possible and once with a simulation that sleeps for each tick, as the
+ * pipeline only pays when a stage waits on a single core. Each frame
+ * presented by the double and triple modes must be the one presented by the
+ * serial mode for the same state, and the double mode must present every
+ * state. */
+
+#include <bench.h>
+#include <pipeline.h>
+#include <entity.h>
+#include <raycaster.h>
+#include <testmap.h>
+#include <sprite.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WIDTH 320
+#define HEIGHT 240
+
+#define FRAMES 300
+#define SPRITES 64
+
+/* The entities simulated on the other map. */
+#define LOAD 20000
+#define LOAD_SIZE 256
+
+/* The time slept by the paced simulation for each tick, in microseconds. */
+#define TICK_US 4000
+
+typedef struct {
+    unsigned long state; /* The number of the state. */
+    fixed_t x, y, r;
+    Sprite sprites[SPRITES];
+} Snapshot;
+
+Entities _entities;
+Sprite _sprites[SPRITES];
+Entities _load;
+Sprite _load_sprites[LOAD];
+unsigned char _load_data[LOAD_SIZE*LOAD_SIZE];
+Tile _load_tileset[2];
+Map _load_map;
+
+Raycaster _r;
+Renderer _buffers[3];
+fixed_t _zbuffer[WIDTH];
+/* The state drawn in each framebuffer. */
+unsigned long _buffer_state[3];
+
+unsigned long _state;
+unsigned long _tick_us;
+
+/* The hash of the frame presented for each state, 0 if it was skipped. */
+unsigned long _hashes[FRAMES];
+unsigned long _serial[FRAMES];
+
+char *_modes[3] = {"serial", "double", "triple"};
+
+/* Place the sprites and the entities, the same way for each run. */
+void _init_entities(void) {
+    int i, x, y;
+    srand(3);
+    entities_init(&_entities, SPRITES);
+    for(i=0;i<SPRITES;i++){
+        do{
+            x = rand()%testmap.width;
+            y = rand()%testmap.height;
+        }while(MAP_TILE(&testmap, x, y));
+        _sprites[i].texture = &sprite;
+        _sprites[i].visible = 1;
+        _sprites[i].extra_data = NULL;
+        entities_add(&_entities, TO_FIXED(x)+TO_FIXED(0.5),
+                     TO_FIXED(y)+TO_FIXED(0.5), TO_FIXED(0.2), _sprites+i);
+        _entities.vx[i] = TO_FIXED(rand()%5-2);
+        _entities.vy[i] = TO_FIXED(rand()%5-2);
+    }
+    entities_init(&_load, LOAD);
+    for(i=0;i<LOAD;i++){
+        do{
+            x = rand()%LOAD_SIZE;
+            y = rand()%LOAD_SIZE;
+        }while(MAP_TILE(&_load_map, x, y));
+        entities_add(&_load, TO_FIXED(x)+TO_FIXED(0.5),
+                     TO_FIXED(y)+TO_FIXED(0.5), TO_FIXED(0.2),
+                     _load_sprites+i);
+        _load.vx[i] = TO_FIXED(rand()%5-2);
+        _load.vy[i] = TO_FIXED(rand()%5-2);
+    }
+}
+
+int _simulate(void *snapshot, const void *previous, void *data) {
+    Snapshot *s = snapshot;
+    (void)previous;
+    (void)data;
+    if(_state >= FRAMES) return 0;
+    if(_tick_us) bench_sleep(_tick_us);
+    entities_update(&_entities, &testmap, TO_FIXED(1)/60);
+    entities_update(&_load, &_load_map, TO_FIXED(1)/60);
+    s->state = _state++;
+    s->x = TO_FIXED(1.5)+(fixed_t)(s->state%200)*TO_FIXED(1)/100;
+    s->y = TO_FIXED(1.5);
+    s->r = TO_FIXED(s->state*2%360);
+    memcpy(s->sprites, _sprites, sizeof(_sprites));
+    return 1;
+}
+
+void _render(const void *snapshot, int buffer, void *data) {
+    const Snapshot *s = snapshot;
+    (void)data;
+    _r.target = _buffers+buffer;
+    _r.x = s->x;
+    _r.y = s->y;
+    _r.r = s->r;
+    raycaster_set_sprites(&_r, (Sprite*)s->sprites, SPRITES);
+    raycaster_render_world(&_r);
+    _buffer_state[buffer] = s->state;
+}
+
+int _present(int buffer, void *data) {
+    (void)data;
+    _hashes[_buffer_state[buffer]] = bench_hash(_buffers[buffer].pixels,
+                                                WIDTH*HEIGHT);
+    return 1;
+}
+
+/* Run the pipeline in mode, returning the number of frames that differ from
+ * the serial mode. */
+int _run(int mode) {
+    Pipeline pipeline;
+    PipelineStats stats;
+    int i, differ = 0;
+    pipeline.simulate = _simulate;
+    pipeline.render = _render;
+    pipeline.present = _present;
+    pipeline.snapshot_size = sizeof(Snapshot);
+    pipeline.data = NULL;
+    _init_entities();
+    _state = 0;
+    memset(_hashes, 0, sizeof(_hashes));
+    if(pipeline_run(&pipeline, mode, &stats)) exit(-1);
+    if(mode == PIPELINE_SERIAL) memcpy(_serial, _hashes, sizeof(_hashes));
+    for(i=0;i<FRAMES;i++){
+        differ += _hashes[i] && _hashes[i] != _serial[i];
+        /* Every state is presented, but by the triple mode. */
+        differ += !_hashes[i] && mode != PIPELINE_TRIPLE;
+    }
+    printf("  %s: %lu simulated, %lu rendered, %lu presented, %.1f frames/s, "
+           "latency %.2f ms on average and %.2f ms at most, %d frames "
+           "differ\n", _modes[mode], stats.simulated, stats.rendered,
+           stats.presented, stats.presented*1000000.0/stats.us,
+           stats.latency_avg/1000.0, stats.latency_max/1000.0, differ);
+    entities_free(&_entities);
+    entities_free(&_load);
+    return differ;
+}
+
+int main(void) {
+    int i, mode, differ = 0;
+    srand(1);
+    for(i=0;i<LOAD_SIZE*LOAD_SIZE;i++) _load_data[i] = rand()%100 < 20;
+    _load_map.data = _load_data;
+    _load_map.width = LOAD_SIZE;
+    _load_map.height = LOAD_SIZE;
+    _load_map.tileset = _load_tileset;
+    for(i=0;i<3;i++) render_init_buffer(_buffers+i, WIDTH, HEIGHT);
+    raycaster_init_target(&_r, _buffers, &testmap, TO_FIXED(1.5),
+                          TO_FIXED(1.5), 0, _zbuffer);
+    for(i=0;i<2;i++){
+        _tick_us = i ? TICK_US : 0;
+        if(i) printf("Simulation sleeping %d ms per tick:\n", TICK_US/1000);
+        else puts("Unpaced simulation:");
+        for(mode=PIPELINE_SERIAL;mode<=PIPELINE_TRIPLE;mode++){
+            differ += _run(mode);
+        }
+    }
+    raycaster_free(&_r);
+    for(i=0;i<3;i++) render_free_buffer(_buffers+i);
+    return differ != 0;
+}
@@ -0,0 +1,104 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Measure the rays that the rotation reuse saves while turning in place on
+ * the test map at 640 rays, with and without adaptive casting, and check
+ * that the frames drawn from the ray cache are the same as the frames drawn
+ * with an empty one. */
+
+#include <bench.h>
+#include <raycaster.h>
+#include <testmap.h>
+
+#include <stdio.h>
+
+#define WIDTH 640
+#define HEIGHT 480
+
+#define FRAMES 300
+
+/* The speeds in degrees per frame, 1.67 being ROTSPEED at 60 FPS. */
+double _speeds[] = {0.5, 1.67, 3, 6, 15};
+
+#define SPEEDS (sizeof(_speeds)/sizeof(_speeds[0]))
+
+int main(void) {
+    Raycaster r;
+    Renderer target;
+    fixed_t zbuffer[WIDTH];
+    unsigned int s;
+    int i, adaptive;
+    int mismatches = 0;
+    unsigned long hash;
+    unsigned long cast[2][SPEEDS], total[SPEEDS];
+    render_init_buffer(&target, WIDTH, HEIGHT);
+    raycaster_init_target(&r, &target, &testmap, 0, 0, 0, zbuffer);
+    r.reuse_rays = 1;
+    for(adaptive=0;adaptive<2;adaptive++){
+        r.adaptive = adaptive;
+        for(s=0;s<SPEEDS;s++){
+            r.x = TO_FIXED(3.5+s);
+            r.y = TO_FIXED(2.5);
+            r.r = TO_FIXED(10);
+            raycaster_render_world(&r);
+            cast[adaptive][s] = total[s] = 0;
+            for(i=0;i<FRAMES;i++){
+                r.r += TO_FIXED(_speeds[s]);
+                if(r.r >= TO_FIXED(360)) r.r -= TO_FIXED(360);
+                raycaster_render_world(&r);
+                cast[adaptive][s] += r.profile.rays_cast;
+                total[s] += r.rays;
+                if(i%25) continue;
+                /* Render the same view again with an empty cache. */
+                hash = bench_hash(target.pixels, WIDTH*HEIGHT);
+                r.ray_cache.rays = 0;
+                raycaster_render_world(&r);
+                if(bench_hash(target.pixels, WIDTH*HEIGHT) != hash){
+                    mismatches++;
+                }
+            }
+        }
+    }
+    puts("deg/frame   rays saved   rays saved with adaptive casting");
+    for(s=0;s<SPEEDS;s++){
+        printf("%-11.2f %-12.1f %.1f\n", _speeds[s],
+               100.0-100.0*cast[0][s]/total[s],
+               100.0-100.0*cast[1][s]/total[s]);
+    }
+    printf("%d frames differ from the same frame with an empty cache\n",
+           mismatches);
+    raycaster_free(&r);
+    render_free_buffer(&target);
+    return mismatches != 0;
+}
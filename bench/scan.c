@@ -0,0 +1,189 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Compare raycaster_scan with a loop over raycaster_raycast casting the same
+ * rays, in full circle scans of 360 and 1080 beams on the test map, and check
+ * that the distances found by raycaster_scan are as close to the exact ones
+ * as the distances found by raycaster_raycast. */
+
+#include <bench.h>
+#include <raycaster.h>
+#include <testmap.h>
+
+#include <stdio.h>
+#include <math.h>
+
+#define PI 3.14159265358979
+
+#define SCANS 2000
+#define MAX_BEAMS 1080
+
+/* Each benchmark is run RUNS times and the fastest run is kept. */
+#define RUNS 3
+
+/* The accuracy is checked on one scan every CHECK_STEP degrees. */
+#define CHECK_STEP 7
+
+/* How much larger than the mean error of raycaster_raycast the mean error of
+ * raycaster_scan may be. */
+#define TOLERANCE 1.1
+
+fixed_t _dist[MAX_BEAMS];
+fixed_t _dist_loop[MAX_BEAMS];
+ScanHit _hits[MAX_BEAMS];
+ScanHit _hits_loop[MAX_BEAMS];
+
+int _beams[] = {360, 1080};
+
+/* The scan k starts at a different angle, like a spinning lidar. */
+#define START(k) TO_FIXED((k)%360)
+
+/* Cast the rays of the scan k with raycaster_raycast. */
+void _scan_loop(Raycaster *r, int k, int n) {
+    int i;
+    fixed_t a;
+    RayEnd end;
+    for(i=0;i<n;i++){
+        a = START(k)-TO_FIXED(180)+TO_FIXED(360)*i/n;
+        end = raycaster_raycast(r, r->x, r->y, r->x+DCOS(a)*r->len,
+                                r->y+DSIN(a)*r->len);
+        _dist_loop[i] = end.hit ? end.len : TO_FIXED(r->len);
+        _hits_loop[i].cx = end.cx;
+        _hits_loop[i].cy = end.cy;
+    }
+}
+
+/* The exact distance from x, y to the first wall in the direction a (in
+ * radians), or -1 if the ray leaves the map. */
+double _exact(Map *map, double x, double y, double a, double len) {
+    double c = cos(a), s = sin(a);
+    double step_x = fabs(1/c), step_y = fabs(1/s);
+    int cx = (int)x, cy = (int)y;
+    double next_x = (c > 0 ? cx+1-x : x-cx)*step_x;
+    double next_y = (s > 0 ? cy+1-y : y-cy)*step_y;
+    double t;
+    for(;;){
+        if(next_x < next_y){
+            t = next_x;
+            cx += c > 0 ? 1 : -1;
+            next_x += step_x;
+        }else{
+            t = next_y;
+            cy += s > 0 ? 1 : -1;
+            next_y += step_y;
+        }
+        if(cx < 0 || cy < 0 || cx >= map->width || cy >= map->height){
+            return -1;
+        }
+        if(t > len) return len;
+        if(MAP_TILE(map, cx, cy)) return t;
+    }
+}
+
+/* Add the errors of the distances of the scan k to *scan_err and *loop_err
+ * and return the number of rays checked. */
+int _check(Raycaster *r, int k, int n, double *scan_err, double *loop_err) {
+    int i, checked = 0;
+    double a, exact;
+    raycaster_scan(r->map, r->x, r->y, START(k), TO_FIXED(360), n, r->len,
+                   SCAN_EUCLIDEAN, _dist, NULL);
+    _scan_loop(r, k, n);
+    for(i=0;i<n;i++){
+        a = (double)(START(k)-TO_FIXED(180)+TO_FIXED(360)*i/n)/TO_FIXED(1);
+        exact = _exact(r->map, (double)r->x/TO_FIXED(1),
+                       (double)r->y/TO_FIXED(1), a*PI/180, r->len);
+        if(exact < 0) continue;
+        *scan_err += fabs((double)_dist[i]/TO_FIXED(1)-exact);
+        *loop_err += fabs((double)_dist_loop[i]/TO_FIXED(1)-exact);
+        checked++;
+    }
+    return checked;
+}
+
+int main(void) {
+    Raycaster r;
+    Renderer target;
+    fixed_t zbuffer[1];
+    unsigned int b;
+    int n, k, run;
+    int checked;
+    double scan_err, loop_err;
+    int worse = 0;
+    unsigned long start, us;
+    unsigned long loop_us, scan_us, hits_us;
+    render_init_buffer(&target, 1, 1);
+    raycaster_init_target(&r, &target, &testmap, TO_FIXED(3.3), TO_FIXED(3.7),
+                          0, zbuffer);
+    for(b=0;b<sizeof(_beams)/sizeof(_beams[0]);b++){
+        n = _beams[b];
+        loop_us = scan_us = hits_us = -1UL;
+        for(run=0;run<RUNS;run++){
+            start = bench_us();
+            for(k=0;k<SCANS;k++) _scan_loop(&r, k, n);
+            us = bench_us()-start;
+            if(us < loop_us) loop_us = us;
+            start = bench_us();
+            for(k=0;k<SCANS;k++){
+                raycaster_scan(&testmap, r.x, r.y, START(k), TO_FIXED(360),
+                               n, r.len, SCAN_EUCLIDEAN, _dist, NULL);
+            }
+            us = bench_us()-start;
+            if(us < scan_us) scan_us = us;
+            start = bench_us();
+            for(k=0;k<SCANS;k++){
+                raycaster_scan(&testmap, r.x, r.y, START(k), TO_FIXED(360),
+                               n, r.len, SCAN_EUCLIDEAN, _dist, _hits);
+            }
+            us = bench_us()-start;
+            if(us < hits_us) hits_us = us;
+        }
+        scan_err = loop_err = 0;
+        checked = 0;
+        for(k=0;k<360;k+=CHECK_STEP){
+            checked += _check(&r, k, n, &scan_err, &loop_err);
+        }
+        scan_err /= checked;
+        loop_err /= checked;
+        if(scan_err > loop_err*TOLERANCE) worse = 1;
+        printf("%d beams: raycaster_scan %.1fk scans/s (%.1fk with the hits), "
+               "raycaster_raycast loop %.1fk scans/s\n", n,
+               SCANS*1000.0/scan_us, SCANS*1000.0/hits_us,
+               SCANS*1000.0/loop_us);
+        printf("%d beams: mean error of raycaster_scan %.5f cells, "
+               "raycaster_raycast %.5f cells\n", n, scan_err, loop_err);
+    }
+    raycaster_free(&r);
+    render_free_buffer(&target);
+    return worse;
+}
@@ -0,0 +1,100 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Compare the time of the span pass, which draws the floor and the ceiling,
+ * with the time of the wall pass, at 640x480 on the open part of the test
+ * map. bench/build.sh builds it twice: spans with the SSE2 kernel of
+ * render_hspan and spans_scalar without it. */
+
+#include <bench.h>
+#include <raycaster.h>
+#include <testmap.h>
+
+#include <stdio.h>
+
+#define WIDTH 640
+#define HEIGHT 480
+
+/* The views are rendered RUNS times and the fastest run is kept. */
+#define RUNS 5
+
+/* The camera turns around in each of these cells. */
+fixed_t _cells[][2] = {
+    {TO_FIXED(15.5), TO_FIXED(10.5)},
+    {TO_FIXED(4.5), TO_FIXED(4.5)},
+    {TO_FIXED(25.5), TO_FIXED(17.5)}
+};
+
+#define CELLS (sizeof(_cells)/sizeof(_cells[0]))
+#define ANGLES 72
+
+int main(void) {
+    Raycaster r;
+    Renderer target;
+    fixed_t zbuffer[WIDTH];
+    unsigned long walls, spans;
+    unsigned long best_walls = -1UL, best_spans = -1UL;
+    unsigned int run, cell, a;
+    render_init_buffer(&target, WIDTH, HEIGHT);
+    raycaster_init_target(&r, &target, &testmap, 0, 0, 0, zbuffer);
+    for(run=0;run<RUNS;run++){
+        walls = spans = 0;
+        for(cell=0;cell<CELLS;cell++){
+            r.x = _cells[cell][0];
+            r.y = _cells[cell][1];
+            for(a=0;a<ANGLES;a++){
+                r.r = TO_FIXED(a*360/ANGLES);
+                raycaster_render_world(&r);
+                walls += r.profile.frame[PROFILE_WALLS];
+                spans += r.profile.frame[PROFILE_SPANS];
+            }
+        }
+        if(walls+spans < best_walls+best_spans){
+            best_walls = walls;
+            best_spans = spans;
+        }
+    }
+#if defined(__SSE2__)
+    fputs("render_hspan with SSE2, ", stdout);
+#else
+    fputs("scalar render_hspan, ", stdout);
+#endif
+    printf("%dx%d, %d views: walls %.0f us, spans %.0f us per frame\n",
+           WIDTH, HEIGHT, (int)(CELLS*ANGLES),
+           (double)best_walls/(CELLS*ANGLES),
+           (double)best_spans/(CELLS*ANGLES));
+    raycaster_free(&r);
+    render_free_buffer(&target);
+    return 0;
+}
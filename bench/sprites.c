@@ -0,0 +1,117 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Measure what the coarse depth buffer saves to the sprite pass on the sprite
+ * map, at 1920x1080 over 360 views: the sprite columns that are rejected by
+ * their depth tile, drawn without a depth test or still tested column by
+ * column, and the time of the sprite pass. */
+
+#include <bench.h>
+#include <raycaster.h>
+#include <spritemap.h>
+
+#include <stdio.h>
+
+#define WIDTH 1920
+#define HEIGHT 1080
+
+#define VIEWS 360
+
+/* The views are rendered RUNS times and the fastest run is kept. */
+#define RUNS 3
+
+fixed_t zbuffer[WIDTH];
+
+/* Turn around in a corner for the first half of the views and in the middle
+ * of the map for the second half. */
+void _set_view(Raycaster *r, int view) {
+    r->r = TO_FIXED(view);
+    if(view < VIEWS/2){
+        r->x = TO_FIXED(1.5);
+        r->y = TO_FIXED(1.5);
+    }else{
+        r->x = TO_FIXED(17.5);
+        r->y = TO_FIXED(17.5);
+    }
+}
+
+int main(void) {
+    Raycaster r;
+    Renderer target;
+    SpriteView *sprite;
+    int view, run;
+    int p, x, k;
+    int start, end;
+    unsigned long columns = 0, rejected = 0, no_test = 0, tested = 0;
+    unsigned long us, best = -1UL;
+    render_init_buffer(&target, WIDTH, HEIGHT);
+    raycaster_init_target(&r, &target, &spritemap, 0, 0, 0, zbuffer);
+    for(view=0;view<VIEWS;view++){
+        _set_view(&r, view);
+        raycaster_render_world(&r);
+        for(p=0;p<r.sprite_num;p++){
+            sprite = r.sprite_views+p;
+            if(sprite->h <= 0) continue;
+            start = sprite->screen_x-sprite->h/2;
+            end = sprite->screen_x+sprite->h/2;
+            if(start < 0) start = 0;
+            if(end > WIDTH) end = WIDTH;
+            for(x=start;x<end;x++){
+                k = x/DEPTH_TILE;
+                columns++;
+                if(r.depth_max[k] <= sprite->dist) rejected++;
+                else if(r.depth_min[k] > sprite->dist) no_test++;
+                else tested++;
+            }
+        }
+    }
+    for(run=0;run<RUNS;run++){
+        us = 0;
+        for(view=0;view<VIEWS;view++){
+            _set_view(&r, view);
+            raycaster_render_world(&r);
+            us += r.profile.frame[PROFILE_SPRITES];
+        }
+        if(us < best) best = us;
+    }
+    if(!columns) columns = 1;
+    printf("%lu sprite columns: %.1f%% rejected by their tile, %.1f%% drawn "
+           "without a depth test, %.1f%% tested\n", columns,
+           100.0*rejected/columns, 100.0*no_test/columns,
+           100.0*tested/columns);
+    printf("sprite pass: %.0f us per frame\n", (double)best/VIEWS);
+    raycaster_free(&r);
+    render_free_buffer(&target);
+    return 0;
+}
@@ -0,0 +1,117 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Render with 8 raycasters at the same time, one per thread, to check that
+ * they don't share any state. They use both test maps, which they share with
+ * each other, and different settings, each drawing into its own
+ * framebuffer. The frames must be the same as when the raycasters render one
+ * after the other. bench/build.sh builds it with ThreadSanitizer as
+ * threads_tsan, which must not report anything. */
+
+#include <bench.h>
+#include <raycaster.h>
+#include <testmap.h>
+#include <spritemap.h>
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#define INSTANCES 8
+#define FRAMES 60
+
+#define WIDTH 320
+#define HEIGHT 240
+
+unsigned long _sequential[INSTANCES][FRAMES];
+unsigned long _concurrent[INSTANCES][FRAMES];
+
+/* Render the frames of the instance n, storing their hashes into hashes. */
+void _render(int n, unsigned long *hashes) {
+    Raycaster r;
+    Renderer target;
+    fixed_t zbuffer[WIDTH];
+    int i;
+    render_init_buffer(&target, WIDTH, HEIGHT);
+    raycaster_init_target(&r, &target, n%2 ? &spritemap : &testmap,
+                          TO_FIXED(2.5), TO_FIXED(2.5), TO_FIXED(n*40),
+                          zbuffer);
+    r.reuse_rays = n%3 == 0;
+    r.adaptive = n%4 == 1;
+    r.strip_width = n%2 ? 0 : 32;
+    for(i=0;i<FRAMES;i++){
+        r.r += TO_FIXED(3);
+        if(r.r >= TO_FIXED(360)) r.r -= TO_FIXED(360);
+        r.x += TO_FIXED(0.02);
+        raycaster_render_world(&r);
+        hashes[i] = bench_hash(target.pixels, WIDTH*HEIGHT);
+    }
+    raycaster_free(&r);
+    render_free_buffer(&target);
+}
+
+void *_thread(void *arg) {
+    int n = *(int*)arg;
+    _render(n, _concurrent[n]);
+    return NULL;
+}
+
+int main(void) {
+    pthread_t threads[INSTANCES];
+    int ids[INSTANCES];
+    int n;
+    int differ = 0;
+    unsigned long start, sequential, concurrent;
+    start = bench_us();
+    for(n=0;n<INSTANCES;n++) _render(n, _sequential[n]);
+    sequential = bench_us()-start;
+    start = bench_us();
+    for(n=0;n<INSTANCES;n++){
+        ids[n] = n;
+        if(pthread_create(threads+n, NULL, _thread, ids+n)){
+            fputs("[threads] Failed to create a thread!\n", stderr);
+            return 1;
+        }
+    }
+    for(n=0;n<INSTANCES;n++) pthread_join(threads[n], NULL);
+    concurrent = bench_us()-start;
+    for(n=0;n<INSTANCES;n++){
+        differ += memcmp(_sequential[n], _concurrent[n],
+                         sizeof(_sequential[n])) != 0;
+    }
+    printf("%d raycasters, %d differ from the sequential run; sequential "
+           "%.1f ms, concurrent %.1f ms\n", INSTANCES, differ,
+           sequential/1000.0, concurrent/1000.0);
+    return differ != 0;
+}
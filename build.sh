@@ -1,7 +1,10 @@
 #!/bin/sh
 
 src="platforms/sdl2/render.c src/main.c src/fixed.c src/raycaster.c src/map.c \
-     conv/wall.c conv/wood.c conv/sprite.c conv/testmap.c"
+     src/profile.c src/mapfile.c src/chunkmap.c src/texpack.c \
+     src/hotreload.c src/batch.c src/los.c src/entity.c src/flowfield.c \
+     src/pipeline.c src/jobs.c src/arena.c src/perfcount.c \
+     conv/wall.c conv/wood.c conv/sprite.c conv/testmap.c conv/spritemap.c"
 
 mkdir -p conv
 
@@ -9,9 +12,18 @@ python3 src/texgen.py assets/wall.png conv/wall.c conv/wall.h
 python3 src/texgen.py assets/wood.png conv/wood.c conv/wood.h
 python3 src/texgen.py assets/sprite.png conv/sprite.c conv/sprite.h
 
+python3 src/texpack.py conv/textures.rtex --mips assets/wall.png \
+        assets/wood.png assets/sprite.png
+
 python3 src/mapgen.py assets/testmap.png assets/testmap.json conv/testmap.c \
         conv/testmap.h
+python3 src/mapgen.py assets/spritemap.png assets/spritemap.json \
+        conv/spritemap.c conv/spritemap.h
+
+python3 src/mapconv.py assets/testmap.png assets/testmap.json conv/testmap.rmap
+python3 src/mapconv.py assets/spritemap.png assets/spritemap.json \
+        conv/spritemap.rmap
 
 cc $src -o main -Wall -Wextra -Wpedantic -g -Isrc -Iplatforms/sdl2 -Iconv \
-        -lSDL2 -lm -ansi
+        -lSDL2 -lm -lpthread -ansi
 
@@ -0,0 +1,38 @@
+#!/bin/sh
+# Build the CG port for the host, to be run from the root of the repository
+# (see host.c).
+
+out=platforms/cg/host/build
+
+# The code of the renderer, built with the basic block counter.
+src="platforms/cg/src/render.c platforms/cg/src/wall.c \
+     platforms/cg/src/wood.c platforms/cg/src/sprite.c src/fixed.c src/raycaster.c src/map.c \
+     src/profile.c src/arena.c $out/testmap.c $out/spritemap.c \
+     $out/img_wall.c $out/img_wood.c $out/img_sprite.c"
+
+mkdir -p $out
+
+for i in wall wood sprite; do
+    python3 platforms/cg/host/imggen.py platforms/cg/assets/$i.png \
+            $out/img_$i.c
+done
+
+python3 src/mapgen.py assets/testmap.png assets/testmap.json $out/testmap.c \
+        $out/testmap.h
+python3 src/mapgen.py assets/spritemap.png assets/spritemap.json \
+        $out/spritemap.c $out/spritemap.h
+
+# -Os like the CG build, and -fwrapv as the fixed point numbers of the CG port
+# overflow like on the calculator.
+flags="-Wall -Wextra -Wpedantic -Os -g -ansi -fwrapv -Iplatforms/cg/host \
+       -Iplatforms/cg/src -Isrc -I$out"
+
+obj=""
+for i in $src; do
+    cc -c $i -o $out/$(basename $i .c).o $flags -fsanitize-coverage=trace-pc \
+       || exit 1
+    obj="$obj $out/$(basename $i .c).o"
+done
+
+cc platforms/cg/host/host.c platforms/cg/host/gint.c $obj -o $out/host $flags \
+   -lm
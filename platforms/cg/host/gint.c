@@ -0,0 +1,172 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* The stand-in for gint and libprof used by the host build of the CG port.
+ * The drawing functions follow gint's, so that the frames are the same as on
+ * the calculator. */
+
+#include <gint/display.h>
+#include <gint/keyboard.h>
+#include <gint/timer.h>
+#include <libprof.h>
+
+#include <time.h>
+
+uint16_t gint_vram[DWIDTH*DHEIGHT];
+
+int image_alpha(int format) {
+    return format == IMAGE_RGB565A ? 0x0001 : -1;
+}
+
+void dclear(int color) {
+    int i;
+    for(i=0;i<DWIDTH*DHEIGHT;i++) gint_vram[i] = color;
+}
+
+void dpixel(int x, int y, int color) {
+    if(x < 0 || x >= DWIDTH || y < 0 || y >= DHEIGHT) return;
+    gint_vram[y*DWIDTH+x] = color;
+}
+
+void drect(int x1, int y1, int x2, int y2, int color) {
+    int x, y;
+    int tmp;
+    if(x1 > x2){
+        tmp = x1;
+        x1 = x2;
+        x2 = tmp;
+    }
+    if(y1 > y2){
+        tmp = y1;
+        y1 = y2;
+        y2 = tmp;
+    }
+    if(x1 < 0) x1 = 0;
+    if(y1 < 0) y1 = 0;
+    if(x2 >= DWIDTH) x2 = DWIDTH-1;
+    if(y2 >= DHEIGHT) y2 = DHEIGHT-1;
+    for(y=y1;y<=y2;y++){
+        for(x=x1;x<=x2;x++) gint_vram[y*DWIDTH+x] = color;
+    }
+}
+
+/* Bresenham's algorithm, starting with half a step of error like gint. */
+void dline(int x1, int y1, int x2, int y2, int color) {
+    int i;
+    int x = x1, y = y1;
+    int dx = x2-x1, dy = y2-y1;
+    int sx = dx < 0 ? -1 : dx > 0;
+    int sy = dy < 0 ? -1 : dy > 0;
+    int cumul;
+    if(y1 == y2 || x1 == x2){
+        drect(x1, y1, x2, y2, color);
+        return;
+    }
+    dx = dx < 0 ? -dx : dx;
+    dy = dy < 0 ? -dy : dy;
+    dpixel(x1, y1, color);
+    if(dx >= dy){
+        cumul = dx>>1;
+        for(i=1;i<dx;i++){
+            x += sx;
+            cumul += dy;
+            if(cumul > dx){
+                cumul -= dx;
+                y += sy;
+            }
+            dpixel(x, y, color);
+        }
+    }else{
+        cumul = dy>>1;
+        for(i=1;i<dy;i++){
+            y += sy;
+            cumul += dx;
+            if(cumul > dy){
+                cumul -= dy;
+                x += sx;
+            }
+            dpixel(x, y, color);
+        }
+    }
+    dpixel(x2, y2, color);
+}
+
+/* The frames are read from gint_vram by the host program. */
+void dupdate(void) {}
+
+void dprint(int x, int y, int fg, char const *format, ...) {
+    (void)x;
+    (void)y;
+    (void)fg;
+    (void)format;
+}
+
+int keydown(int key) {
+    (void)key;
+    return 0;
+}
+
+void clearevents(void) {}
+
+int timer_configure(int timer, uint64_t delay_us, gint_call_t callback) {
+    (void)timer;
+    (void)delay_us;
+    (void)callback;
+    return 0;
+}
+
+void timer_start(int timer) {
+    (void)timer;
+}
+
+void timer_stop(int timer) {
+    (void)timer;
+}
+
+int prof_init(void) {
+    return 0;
+}
+
+prof_t prof_make(void) {
+    prof_t prof = {0, 0};
+    return prof;
+}
+
+uint32_t prof_clock(void) {
+    return (uint32_t)((double)clock()*1000000/CLOCKS_PER_SEC);
+}
+
+uint32_t prof_time(prof_t prof) {
+    return prof.elapsed;
+}
@@ -0,0 +1,93 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* A stand-in for the parts of gint's display API used by the CG port, to
+ * build it on a host (see host.c). */
+
+#ifndef GINT_DISPLAY_H
+#define GINT_DISPLAY_H
+
+#include <stdint.h>
+
+#define DWIDTH 396
+#define DHEIGHT 224
+
+/* Each component has 5 bits, the low bit of green is always 0. */
+#define C_RGB(r, g, b) (((r)<<11) | ((g)<<6) | (b))
+
+#define C_WHITE 0xFFFF
+#define C_LIGHT 0xAD55
+#define C_DARK  0x528A
+#define C_BLACK 0x0000
+
+/* The formats of image_t that the CG port reads. */
+enum {
+    IMAGE_RGB565 = 0,
+    IMAGE_RGB565A = 1
+};
+
+typedef struct {
+    uint8_t format;
+    uint8_t flags;
+    int16_t color_count;
+    uint16_t width;
+    uint16_t height;
+    int stride; /* Bytes per row. */
+    void *data;
+    uint16_t *palette;
+} image_t;
+
+typedef image_t bopti_image_t;
+
+/* The frame being drawn. */
+extern uint16_t gint_vram[DWIDTH*DHEIGHT];
+
+/* The value of the transparent pixels of the images of format. */
+int image_alpha(int format);
+
+void dclear(int color);
+
+void dpixel(int x, int y, int color);
+
+void dline(int x1, int y1, int x2, int y2, int color);
+
+/* Fill the rectangle from x1, y1 to x2, y2 (included). */
+void drect(int x1, int y1, int x2, int y2, int color);
+
+void dupdate(void);
+
+/* Text is not drawn. */
+void dprint(int x, int y, int fg, char const *format, ...);
+
+#endif
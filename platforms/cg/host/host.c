@@ -0,0 +1,151 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Render the world view of the CG port on the host, without the calculator,
+ * to check its frames and estimate the work done per frame.
+ *
+ * The code of the CG port (render.c, the textures in the format of gint) is
+ * run with gint.c in place of gint. The frames of a fixed camera path are
+ * drawn into gint_vram and hashed, so that two versions of the renderer can
+ * be compared pixel for pixel. The renderer is built with
+ * -fsanitize-coverage=trace-pc to count the basic blocks that it runs, a
+ * proxy for the instructions run on the calculator. */
+
+#include <render.h>
+#include <raycaster.h>
+#include <fixed.h>
+#include <testmap.h>
+#include <spritemap.h>
+
+#include <gint/display.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define FRAMES 300
+
+Raycaster raycaster;
+
+unsigned long _blocks = 0;
+
+/* Called by the compiler at the start of each basic block of the renderer. */
+void __sanitizer_cov_trace_pc(void) {
+    _blocks++;
+}
+
+unsigned long _hash_vram(void) {
+    unsigned long h = 5381;
+    int i;
+    for(i=0;i<DWIDTH*DHEIGHT;i++) h = h*33^gint_vram[i];
+    return h;
+}
+
+int _write_ppm(char *file) {
+    FILE *fp = fopen(file, "wb");
+    int i;
+    uint16_t c;
+    if(fp == NULL){
+        fprintf(stderr, "[host] Failed to open %s!\n", file);
+        return -1;
+    }
+    fprintf(fp, "P6\n%d %d\n255\n", DWIDTH, DHEIGHT);
+    for(i=0;i<DWIDTH*DHEIGHT;i++){
+        c = gint_vram[i];
+        fputc((c>>11)<<3, fp);
+        fputc(((c>>5)&0x3F)<<2, fp);
+        fputc((c&0x1F)<<3, fp);
+    }
+    fclose(fp);
+    return 0;
+}
+
+/* Move the camera along the path, turning during the first third of the
+ * frames and walking during the second one. */
+void _move(int frame) {
+    if(frame < FRAMES/3){
+        raycaster.r += TO_FIXED(2);
+    }else if(frame < FRAMES*2/3){
+        raycaster.x += TO_FIXED(0.05);
+        raycaster.y += TO_FIXED(0.04);
+    }
+}
+
+int main(int argc, char **argv) {
+    fixed_t zbuffer[DWIDTH];
+    Map *maps[2] = {&testmap, &spritemap};
+    int dump = -1;
+    int i, pass;
+    unsigned long hash;
+    unsigned long total = 0;
+    unsigned long blocks;
+    unsigned long max;
+    clock_t start;
+    if(argc > 1 && argc != 3){
+        fputs("USAGE: host [FRAME] [PPM FILE]\n", stderr);
+        return 1;
+    }
+    if(argc > 2) dump = atoi(argv[1]);
+    for(pass=0;pass<2;pass++){
+        /* The same settings as main.c. */
+        raycaster_init(&raycaster, DWIDTH, DHEIGHT, "Host", maps[pass],
+                       TO_FIXED(1.5), TO_FIXED(1.5), TO_FIXED(45), zbuffer);
+        raycaster.adaptive = 1;
+        raycaster.reuse_rays = 1;
+        if(pass){
+            raycaster.x = TO_FIXED(2.5);
+            raycaster.y = TO_FIXED(2.5);
+        }
+        hash = 0;
+        max = 0;
+        _blocks = 0;
+        start = clock();
+        for(i=0;i<FRAMES;i++){
+            _move(i);
+            blocks = _blocks;
+            raycaster_render_world(&raycaster);
+            if(_blocks-blocks > max) max = _blocks-blocks;
+            hash ^= _hash_vram()*(i+1);
+            if(pass*FRAMES+i == dump && _write_ppm(argv[2])) return 1;
+        }
+        printf("%s: hash %016lx, %lu basic blocks per frame (%lu max), "
+               "%.3f ms per frame on the host\n",
+               pass ? "spritemap" : "testmap", hash, _blocks/FRAMES, max,
+               (double)(clock()-start)*1000/CLOCKS_PER_SEC/FRAMES);
+        total ^= hash;
+        raycaster_free(&raycaster);
+    }
+    printf("total %016lx\n", total);
+    return 0;
+}
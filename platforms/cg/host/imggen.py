@@ -0,0 +1,113 @@
+"""
+A quick and dirty raycaster.
+imggen.py: convert an image to a bopti_image_t for the host build of the CG
+port.
+by Mibi88
+
+This software is licensed under the BSD-3-Clause license:
+
+Copyright (c) 2024 Mibi88.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holder nor the names of its
+    contributors may be used to endorse or promote products derived from this
+    software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+"""
+
+
+from PIL import Image
+import sys
+import os
+
+# The value of the transparent pixels, see image_alpha in gint.c.
+ALPHA = 0x0001
+
+if len(sys.argv) < 3:
+    sys.stderr.write("USAGE: imggen [FILE] [C SOURCE]\n")
+    sys.exit(1)
+
+infile = sys.argv[1]
+source = sys.argv[2]
+
+name = os.path.splitext(os.path.basename(infile))[0]
+
+img = Image.open(infile)
+
+# Like fxconv, the images with an alpha channel are converted to RGB565A and
+# the other ones to RGB565.
+alpha = "A" in img.getbands()
+
+img = img.convert("RGBA")
+
+w, h = img.size
+
+pxlist = []
+
+for y in range(h):
+    for x in range(w):
+        r, g, b, a = img.getpixel((x, y))
+        c = (r&0xF8)<<8|(g&0xFC)<<3|b>>3
+        if alpha:
+            if a < 128:
+                c = ALPHA
+            elif c == ALPHA:
+                c = 0
+        pxlist.append(c)
+
+out = f"""#include <gint/display.h>
+#include <stddef.h>
+#include <stdint.h>
+
+uint16_t _{name.lower()}_data[{w*h}] = {{
+"""
+
+INDENT = 4
+MAX_COLUMN = 79 # Column 80 for line feed.
+
+column = 4
+
+out += ' '*INDENT
+
+for n in range(len(pxlist)):
+    i = pxlist[n]
+    string = f"0x{i:04x}, "
+    if n >= len(pxlist)-1:
+        string = string[:-2]
+    if column+len(string) >= MAX_COLUMN:
+        out = out[:-1]
+        out += '\n'
+        out += ' '*INDENT
+        column = INDENT
+    out += string
+    column += len(string)
+
+fmt = "IMAGE_RGB565A" if alpha else "IMAGE_RGB565"
+
+out += f"""
+}};
+
+bopti_image_t _{name.lower()} = {{
+    {fmt}, 0, 0, {w}, {h}, {w*2}, _{name.lower()}_data, NULL
+}};\n
+"""
+
+with open(source, "w") as fp:
+    fp.write(out)
@@ -36,17 +36,35 @@
 #include <gint/keyboard.h>
 #include <gint/display.h>
 #include <gint/timer.h>
+#include <libprof.h>
+
+#include <string.h>
 
 #define COLOR_FIX1 (DIV(TO_FIXED(15), TO_FIXED(255)))
 #define COLOR_FIX2 (DIV(TO_FIXED(31), TO_FIXED(255)))
 
 fixed_t _lut_fog[256];
+char _lut_fog_ready = 0;
+
+/* The time since render_init, measured with libprof. */
+prof_t _prof;
+unsigned long _prof_us;
+char _prof_ready = 0;
 
 void render_init(Renderer *renderer, int width, int height, char *title) {
     int i;
-    /* Generate a LUT for the fog */
-    for(i=0;i<256;i++){
-        _lut_fog[i] = TO_FIXED(i)/255;
+    /* Generate a LUT for the fog, which is then only read. */
+    if(!_lut_fog_ready){
+        for(i=0;i<256;i++){
+            _lut_fog[i] = TO_FIXED(i)/255;
+        }
+        _lut_fog_ready = 1;
+    }
+    if(!_prof_ready && !prof_init()){
+        _prof = prof_make();
+        prof_enter(_prof);
+        _prof_us = 0;
+        _prof_ready = 1;
     }
     /* Clear the screen */
     dclear(C_WHITE);
@@ -133,6 +151,138 @@ void render_texvline(Renderer *renderer, Texture *tex, int y1, int y2, int ty1,
     }
 }
 
+void render_texvline_label(Renderer *renderer, Texture *tex, int y1, int y2,
+                           int ty1, int ty2, int x, int l,
+                           unsigned short *labels, unsigned short label) {
+    int y;
+    int p;
+    int t;
+    uint16_t *texel;
+    unsigned int h = ABS(ty2-ty1);
+    ufixed_t texinc = UFDIV(UTO_FIXED(tex->i->height), UTO_FIXED(h ? h : 1));
+    if(x < 0 || x >= DWIDTH) return;
+    if(y1 < 0) y1 = 0;
+    else if(y1 >= DHEIGHT) y1 = DHEIGHT-1;
+    if(y2 >= DHEIGHT) y2 = DHEIGHT-1;
+    else if(y2 < 0) y2 = 0;
+    if(l >= tex->i->width) l = tex->i->width-1;
+    else if(l < 0) l = 0;
+    texel = (uint16_t*)tex->i->data+l;
+    for(t=y1-ty1,y=y1;y<y2;y++,t++){
+        p = UTO_INT(texinc*t);
+        if(p < 0) p = 0;
+        else if(p >= tex->i->height) p = tex->i->height-1;
+        if(texel[p*tex->i->width] == image_alpha(IMAGE_RGB565A) &&
+           tex->i->format == IMAGE_RGB565A) continue;
+        labels[y*DWIDTH+x] = label;
+    }
+}
+
+void render_hspan(Renderer *renderer, Span *span, int x1, int x2, int y) {
+    int x;
+    fixed_t u = span->x;
+    fixed_t v = span->y;
+    int cx, cy;
+    int tile;
+    bopti_image_t *img;
+    uint16_t c;
+    uint16_t tmp;
+    uint16_t *row;
+    fixed_t m = _lut_fog[span->fog&0xFF];
+    if(y < 0 || y >= DHEIGHT) return;
+    if(x1 < 0){
+        u -= span->dx*x1;
+        v -= span->dy*x1;
+        x1 = 0;
+    }
+    if(x2 > DWIDTH) x2 = DWIDTH;
+    row = gint_vram+y*DWIDTH;
+    for(x=x1;x<x2;x++,u+=span->dx,v+=span->dy){
+        cx = TO_INT(u);
+        cy = TO_INT(v);
+        if(cx < 0 || cx >= span->map_width || cy < 0 ||
+           cy >= span->map_height) continue;
+        tile = span->layer[cy*span->map_width+cx];
+        if(!tile) continue;
+        img = span->tileset[tile-1].texture->i;
+        tmp = ((uint16_t*)img->data)[TO_INT((v-FLOOR(v))*img->height)*
+                                     img->width+
+                                     TO_INT((u-FLOOR(u))*img->width)];
+        c = TO_INT((tmp&0x1F)*m)&0x1F;
+        c |= (TO_INT(((tmp>>5)&0x3F)*m)&0x3F)<<5;
+        c |= (TO_INT(((tmp>>11)&0x1F)*m)&0x1F)<<11;
+        row[x] = c;
+    }
+}
+
+Pixel render_color(int r, int g, int b) {
+    r = TO_INT(r*COLOR_FIX1);
+    g = TO_INT(g*COLOR_FIX2);
+    b = TO_INT(b*COLOR_FIX1);
+    return C_RGB(r, g, b);
+}
+
+void render_blit(Renderer *renderer, Pixel *image, int w, int h, int x, int y,
+                 int scale, int cx, int cy, int cw, int ch) {
+    int dx, dy;
+    int sx, sy;
+    int x1, y1, x2, y2;
+    int end;
+    Pixel c;
+    Pixel *row;
+    Pixel *src;
+    if(scale < 1) return;
+    /* Clip the image to the rectangle and to the screen. */
+    x1 = x > cx ? x : cx;
+    y1 = y > cy ? y : cy;
+    x2 = x+w*scale < cx+cw ? x+w*scale : cx+cw;
+    y2 = y+h*scale < cy+ch ? y+h*scale : cy+ch;
+    if(x1 < 0) x1 = 0;
+    if(y1 < 0) y1 = 0;
+    if(x2 > DWIDTH) x2 = DWIDTH;
+    if(y2 > DHEIGHT) y2 = DHEIGHT;
+    for(dy=y1;dy<y2;dy++){
+        row = gint_vram+dy*DWIDTH;
+        sy = (dy-y)/scale;
+        /* The rows that come from the same row of the image are copied. */
+        if(dy > y1 && (dy-1-y)/scale == sy){
+            memcpy(row+x1, row-DWIDTH+x1, (x2-x1)*sizeof(Pixel));
+            continue;
+        }
+        src = image+sy*w;
+        for(dx=x1;dx<x2;){
+            sx = (dx-x)/scale;
+            c = src[sx];
+            end = x+(sx+1)*scale;
+            if(end > x2) end = x2;
+            for(;dx<end;dx++) row[dx] = c;
+        }
+    }
+}
+
+void render_upscale(Renderer *renderer, int w, int h) {
+    int x, y;
+    int sy;
+    int last_sy = -1;
+    uint16_t *row;
+    uint16_t *src;
+    /* Done in place from the bottom right corner, so that no pixel is
+     * overwritten before being read. */
+    for(y=DHEIGHT-1;y>=0;y--){
+        sy = y*h/DHEIGHT;
+        row = gint_vram+y*DWIDTH;
+        if(sy == last_sy){
+            memcpy(row, row+DWIDTH, DWIDTH*sizeof(uint16_t));
+            continue;
+        }
+        src = gint_vram+sy*DWIDTH;
+        for(x=DWIDTH-1;x>=0;x--){
+            row[x] = src[x*w/DWIDTH];
+        }
+        last_sy = sy;
+    }
+}
+
 void render_update(Renderer *renderer) {
     dupdate();
 }
@@ -155,7 +305,20 @@ int render_get_height(Renderer *renderer) {
 }
 
 int render_ms(Renderer *renderer) {
-    return 0; /* TODO */
+    return render_us(renderer)/1000;
+}
+
+unsigned long render_us(Renderer *renderer) {
+    /* The time is added up in microseconds and the counter restarted, so that
+     * it wraps around like an unsigned long and not like the timer. It stays
+     * 0 if libprof had no free timer. */
+    if(_prof_ready){
+        prof_leave(_prof);
+        _prof_us += prof_time(_prof);
+        _prof = prof_make();
+        prof_enter(_prof);
+    }
+    return _prof_us;
 }
 
 int _fps;
@@ -164,6 +327,11 @@ void render_show_fps(Renderer *renderer) {
     dprint(8, 8, C_LIGHT, "FPS: %d", _fps);
 }
 
+void render_show_text(Renderer *renderer, char *text) {
+    render_show_fps(renderer);
+    dprint(8, 20, C_LIGHT, "%s", text);
+}
+
 int _ms_time;
 
 int timer_call(void) {
@@ -39,8 +39,10 @@
 
 #include <texture.h>
 #include <fixed.h>
+#include <map.h>
 
 #include <gint/keyboard.h>
+#include <stdint.h>
 
 /* Some key codes. */
 enum {
@@ -53,6 +55,9 @@ enum {
 
 typedef void* Renderer;
 
+/* A pixel in the format of the screen. */
+typedef uint16_t Pixel;
+
 void render_init(Renderer *renderer, int width, int height, char *title);
 
 void render_set_pixel(Renderer *renderer, int x, int y, int r, int g, int b);
@@ -69,6 +74,28 @@ void render_vline(Renderer *renderer, int y1, int y2, int x, int r, int g,
 void render_texvline(Renderer *renderer, Texture *tex, int y1, int y2, int ty1,
                      int ty2, int x, int l, int fog);
 
+/* Set the entries of labels, a plane of labels with one entry per pixel of the
+ * screen, to label where render_texvline would draw an opaque texel. */
+void render_texvline_label(Renderer *renderer, Texture *tex, int y1, int y2,
+                           int ty1, int ty2, int x, int l,
+                           unsigned short *labels, unsigned short label);
+
+/* Draw the pixels x1 to x2 (excluded) of the row y, textured with the tiles of
+ * span->layer. */
+void render_hspan(Renderer *renderer, Span *span, int x1, int x2, int y);
+
+/* Get the color r, g, b in the format of the screen. */
+Pixel render_color(int r, int g, int b);
+
+/* Draw image, which is w by h pixels, scaled up scale times with its top left
+ * corner at x, y. Only the part of it that is in the rectangle cx, cy, cw, ch
+ * is drawn. */
+void render_blit(Renderer *renderer, Pixel *image, int w, int h, int x, int y,
+                 int scale, int cx, int cy, int cw, int ch);
+
+/* Scale the top left w by h pixels of the screen up to the whole screen. */
+void render_upscale(Renderer *renderer, int w, int h);
+
 void render_update(Renderer *renderer);
 
 void render_clear(Renderer *renderer, char black);
@@ -81,8 +108,13 @@ int render_get_height(Renderer *renderer);
 
 int render_ms(Renderer *renderer);
 
+unsigned long render_us(Renderer *renderer);
+
 void render_show_fps(Renderer *renderer);
 
+/* Show the FPS counter along with a line of text. */
+void render_show_text(Renderer *renderer, char *text);
+
 void render_main_loop(Renderer *renderer, void (*loop_function)(int));
 
 #endif
@@ -43,4 +43,48 @@
  */
 #define NOCLEAR 0
 
+/* Set MAPFILE to 1 to be able to load binary map files (see mapfile.h). Needs
+ * mmap.
+ */
+#define MAPFILE 1
+
+/* Set CHUNKMAP to 1 to be able to stream big maps from map files by chunks
+ * (see chunkmap.h). Needs pthreads.
+ */
+#define CHUNKMAP 1
+
+/* Set TEXPACK to 1 to be able to load the textures from texture packs (see
+ * texpack.h). Needs mmap.
+ */
+#define TEXPACK 1
+
+/* Set HOTRELOAD to 1 to reload the map file and the texture pack when they
+ * change (see hotreload.h). Needs MAPFILE, TEXPACK, pthreads and inotify
+ * (Linux only).
+ */
+#define HOTRELOAD 1
+
+/* Set BATCH to 1 to be able to render the views of many cameras in one call
+ * with several threads (see batch.h). Needs pthreads.
+ */
+#define BATCH 1
+
+/* Set PIPELINE to 1 to be able to simulate, render and present frames on
+ * separate threads (see pipeline.h). Needs pthreads and the atomic builtins of
+ * GCC or clang.
+ */
+#define PIPELINE 1
+
+/* Set JOBS to 1 to be able to share the strips of a frame between threads with
+ * a work-stealing scheduler (see jobs.h and Raycaster.jobs). Needs pthreads
+ * and the atomic builtins of GCC or clang.
+ */
+#define JOBS 1
+
+/* Set PERFCOUNT to 1 to count the processor events of each stage of the
+ * frames, such as the cache misses (see perfcount.h and Profile.counters).
+ * Linux only.
+ */
+#define PERFCOUNT 1
+
 #endif
@@ -37,6 +37,21 @@
 
 #include <fixed.h>
 
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Pack a color in the format of the framebuffer (RGBA8888). */
+#define RGBA(r, g, b) ((unsigned int)(r)<<24 | (unsigned int)(g)<<16 | \
+                       (unsigned int)(b)<<8 | 0xFF)
+
+/* Apply the fog to a RGBA8888 texel. f is between 1 and 256. */
+#define SHADE(c, f) (((((c)>>24)*(f))>>8)<<24 | \
+                     (((((c)>>16)&0xFF)*(f))>>8)<<16 | \
+                     (((((c)>>8)&0xFF)*(f))>>8)<<8 | 0xFF)
+
 void render_init(Renderer *renderer, int width, int height, char *title) {
     if(SDL_Init(SDL_INIT_VIDEO) < 0){
         fputs("[render] Failed to initialize the SDL2!", stderr);
@@ -61,121 +76,337 @@ void render_init(Renderer *renderer, int width, int height, char *title) {
     SDL_SetHint(SDL_HINT_RENDER_VSYNC, "1");
     renderer->w = width;
     renderer->h = height;
+    /* Everything is drawn into a framebuffer which is copied into this
+     * texture by render_update. */
+    renderer->texture = SDL_CreateTexture(renderer->renderer,
+                                          SDL_PIXELFORMAT_RGBA8888,
+                                          SDL_TEXTUREACCESS_STREAMING,
+                                          width, height);
+    renderer->pixels = malloc(width*height*sizeof(unsigned int));
+    if(!renderer->texture || !renderer->pixels){
+        fputs("[render] Failed to create the framebuffer!", stderr);
+        SDL_DestroyRenderer(renderer->renderer);
+        SDL_DestroyWindow(renderer->window);
+        exit(-1);
+    }
     SDL_MaximizeWindow(renderer->window);
-    SDL_SetRenderDrawBlendMode(renderer->renderer, SDL_BLENDMODE_BLEND);
     render_clear(renderer, 0);
 }
 
+void render_init_buffer(Renderer *renderer, int width, int height) {
+    renderer->window = NULL;
+    renderer->renderer = NULL;
+    renderer->texture = NULL;
+    renderer->w = width;
+    renderer->h = height;
+    renderer->fps = 0;
+    renderer->pixels = malloc(width*height*sizeof(unsigned int));
+    if(!renderer->pixels){
+        fputs("[render] Failed to create the framebuffer!", stderr);
+        exit(-1);
+    }
+    render_clear(renderer, 0);
+}
+
+void render_init_pixels(Renderer *renderer, Pixel *pixels, int width,
+                        int height) {
+    renderer->window = NULL;
+    renderer->renderer = NULL;
+    renderer->texture = NULL;
+    renderer->w = width;
+    renderer->h = height;
+    renderer->fps = 0;
+    renderer->pixels = pixels;
+}
+
+void render_free_buffer(Renderer *renderer) {
+    free(renderer->pixels);
+    renderer->pixels = NULL;
+}
+
 void render_set_pixel(Renderer *renderer, int x, int y, int r, int g, int b) {
     if(x >= 0 && x < renderer->w && y >= 0 && y < renderer->h){
-        SDL_SetRenderDrawColor(renderer->renderer, r, g, b, 255);
-        SDL_RenderDrawPoint(renderer->renderer, x, y);
+        renderer->pixels[y*renderer->w+x] = RGBA(r, g, b);
     }
 }
 
 void render_line(Renderer *renderer, int x1, int y1, int x2, int y2, int r,
                  int g, int b) {
-    SDL_SetRenderDrawColor(renderer->renderer, r, g, b, 255);
-    SDL_RenderDrawLine(renderer->renderer, x1, y1, x2, y2);
+    /* Bresenham's line algorithm. */
+    int dx = ABS(x2-x1);
+    int dy = -ABS(y2-y1);
+    int sx = x1 < x2 ? 1 : -1;
+    int sy = y1 < y2 ? 1 : -1;
+    int err = dx+dy;
+    int e2;
+    for(;;){
+        render_set_pixel(renderer, x1, y1, r, g, b);
+        if(x1 == x2 && y1 == y2) break;
+        e2 = 2*err;
+        if(e2 >= dy){
+            err += dy;
+            x1 += sx;
+        }
+        if(e2 <= dx){
+            err += dx;
+            y1 += sy;
+        }
+    }
 }
 
 void render_rect(Renderer *renderer, int sx, int sy, int w, int h, int r,
                  int g, int b) {
-    SDL_Rect rect;
-    rect.x = sx;
-    rect.y = sy;
-    rect.w = w;
-    rect.h = h;
-    SDL_SetRenderDrawColor(renderer->renderer, r, g, b, 255);
-    SDL_RenderFillRect(renderer->renderer, &rect);
+    int x, y;
+    unsigned int c = RGBA(r, g, b);
+    unsigned int *row;
+    int x2 = sx+w;
+    int y2 = sy+h;
+    if(sx < 0) sx = 0;
+    if(sy < 0) sy = 0;
+    if(x2 > renderer->w) x2 = renderer->w;
+    if(y2 > renderer->h) y2 = renderer->h;
+    for(y=sy;y<y2;y++){
+        row = renderer->pixels+y*renderer->w;
+        for(x=sx;x<x2;x++){
+            row[x] = c;
+        }
+    }
 }
 
 void render_vline(Renderer *renderer, int y1, int y2, int x, int r, int g,
                   int b) {
     int y;
+    unsigned int c = RGBA(r, g, b);
+    unsigned int *px;
     if(x < 0 || x >= renderer->w) return;
     if(y1 < 0) y1 = 0;
-    else if(y1 >= renderer->h) y1 = renderer->h-1;
-    if(y2 >= renderer->h) y2 = renderer->h-1;
-    else if(y2 < 0) y2 = 0;
-    SDL_SetRenderDrawColor(renderer->renderer, r, g, b, 255);
-    SDL_RenderDrawLine(renderer->renderer, x, y1, x, y2);
+    if(y2 > renderer->h) y2 = renderer->h;
+    px = renderer->pixels+y1*renderer->w+x;
+    for(y=y1;y<y2;y++,px+=renderer->w){
+        *px = c;
+    }
 }
 
 void render_texvline(Renderer *renderer, Texture *tex, int y1, int y2, int ty1,
                      int ty2, int x, int l, int fog) {
-#if FAST_TEXTURING
-    SDL_Rect texrect;
-    SDL_Rect destrect;
-    if(!tex->extradata){
-        /* Create an SDL texture. */
-        tex->extradata = SDL_CreateTexture(renderer->renderer,
-                                           SDL_PIXELFORMAT_RGBA8888,
-                                           SDL_TEXTUREACCESS_STREAMING,
-                                           tex->width, tex->height);
-        if(!tex->extradata){
-            return;
-        }
-        if(SDL_UpdateTexture(tex->extradata, NULL, tex->data, tex->width*4)){
-            return;
-        }
-        SDL_SetTextureBlendMode(tex->extradata, SDL_BLENDMODE_BLEND);
-    }
-    if(l < 0 || l >= tex->width) return;
-    texrect.x = l;
-    texrect.y = 0;
-    texrect.w = 1;
-    texrect.h = tex->height;
-    destrect.x = x;
-    destrect.y = ty1 < y2 ? ty1 : ty2;
-    destrect.w = 1;
-    destrect.h = ABS(ty2-ty1);
-    SDL_SetTextureColorMod(tex->extradata, fog, fog, fog);
-    SDL_RenderCopyEx(renderer->renderer, tex->extradata, &texrect, &destrect,
-                     0, NULL, SDL_FLIP_NONE);
-#else
     int y;
-    int r, g, b;
     int p;
-    int n;
-    int t;
+    unsigned int c;
+    unsigned int f = fog+1;
+    unsigned int *px;
+    const unsigned int *texel;
     unsigned int h = ABS(ty2-ty1);
     ufixed_t texinc = UTO_FIXED(tex->height)/(h ? h : 1);
+    ufixed_t t;
     if(x < 0 || x >= renderer->w) return;
     if(y1 < 0) y1 = 0;
-    else if(y1 >= renderer->h) y1 = renderer->h-1;
-    if(y2 >= renderer->h) y2 = renderer->h-1;
-    else if(y2 < 0) y2 = 0;
+    if(y2 > renderer->h) y2 = renderer->h;
     if(l >= tex->width) l = tex->width-1;
     else if(l < 0) l = 0;
-    for(t=y1-ty1,n=0,y=y1;y<y2;y+=y1<y2 ? 1 : -1,n++,t++){
-        p = UTO_INT(texinc*t);
-        if(p < 0) p = 0;
-        else if(p >= tex->height) p = tex->height-1;
-        r = tex->data[p*tex->width+l]>>24;
-        g = (tex->data[p*tex->width+l]>>16)&0xFF;
-        b = (tex->data[p*tex->width+l]>>8)&0xFF;
-        r = TO_INT(TO_FIXED(r)/255*fog);
-        g = TO_INT(TO_FIXED(g)/255*fog);
-        b = TO_INT(TO_FIXED(b)/255*fog);
-        SDL_SetRenderDrawColor(renderer->renderer, r, g, b, 255);
-        SDL_RenderDrawPoint(renderer->renderer, x, y);
+    texel = tex->data+l;
+    px = renderer->pixels+y1*renderer->w+x;
+    for(t=texinc*(y1-ty1),y=y1;y<y2;y++,t+=texinc,px+=renderer->w){
+        p = UTO_INT(t);
+        if(p >= tex->height) p = tex->height-1;
+        c = texel[p*tex->width];
+        /* Skip transparent texels (used by sprites). */
+        if(!(c&0xFF)) continue;
+        *px = SHADE(c, f);
     }
+}
+
+void render_texvline_label(Renderer *renderer, Texture *tex, int y1, int y2,
+                           int ty1, int ty2, int x, int l,
+                           unsigned short *labels, unsigned short label) {
+    int y;
+    int p;
+    const unsigned int *texel;
+    unsigned int h = ABS(ty2-ty1);
+    ufixed_t texinc = UTO_FIXED(tex->height)/(h ? h : 1);
+    ufixed_t t;
+    if(x < 0 || x >= renderer->w) return;
+    if(y1 < 0) y1 = 0;
+    if(y2 > renderer->h) y2 = renderer->h;
+    if(l >= tex->width) l = tex->width-1;
+    else if(l < 0) l = 0;
+    texel = tex->data+l;
+    labels += y1*renderer->w+x;
+    for(t=texinc*(y1-ty1),y=y1;y<y2;y++,t+=texinc,labels+=renderer->w){
+        p = UTO_INT(t);
+        if(p >= tex->height) p = tex->height-1;
+        if(texel[p*tex->width]&0xFF) *labels = label;
+    }
+}
+
+void render_hspan(Renderer *renderer, Span *span, int x1, int x2, int y) {
+    int x;
+    int32_t u, v, du, dv;
+    int cx, cy;
+    int tile;
+    Texture *tex;
+    unsigned int c;
+    unsigned int f = span->fog+1;
+    unsigned int *row;
+#if defined(__SSE2__)
+    int n;
+    int32_t cu[4], cv[4];
+    int32_t fu[4], fv[4];
+    unsigned int texels[4];
+    unsigned int keep[4];
+    __m128i vu, vv, vdu, vdv, frac, zero, vf, lo, hi, px, mask;
+#endif
+    if(y < 0 || y >= renderer->h) return;
+    /* Coordinates are stepped with 32-bit integers in the same precision as
+     * fixed_t. The caller makes sure they fit. */
+    u = span->x+span->dx*(x1 < 0 ? -x1 : 0);
+    v = span->y+span->dy*(x1 < 0 ? -x1 : 0);
+    du = span->dx;
+    dv = span->dy;
+    if(x1 < 0) x1 = 0;
+    if(x2 > renderer->w) x2 = renderer->w;
+    row = renderer->pixels+y*renderer->w;
+    x = x1;
+#if defined(__SSE2__)
+    /* Four pixels at a time: the texture coordinates and the fog are
+     * computed with SSE2, only the texel fetch is scalar. */
+    vu = _mm_set_epi32(u+3*du, u+2*du, u+du, u);
+    vv = _mm_set_epi32(v+3*dv, v+2*dv, v+dv, v);
+    vdu = _mm_set1_epi32(4*du);
+    vdv = _mm_set1_epi32(4*dv);
+    frac = _mm_set1_epi32((1<<PRECISION)-1);
+    zero = _mm_setzero_si128();
+    vf = _mm_set1_epi16(f);
+    for(;x+4<=x2;x+=4){
+        _mm_storeu_si128((__m128i*)cu, _mm_srai_epi32(vu, PRECISION));
+        _mm_storeu_si128((__m128i*)cv, _mm_srai_epi32(vv, PRECISION));
+        _mm_storeu_si128((__m128i*)fu, _mm_and_si128(vu, frac));
+        _mm_storeu_si128((__m128i*)fv, _mm_and_si128(vv, frac));
+        vu = _mm_add_epi32(vu, vdu);
+        vv = _mm_add_epi32(vv, vdv);
+        for(n=0;n<4;n++){
+            texels[n] = 0;
+            keep[n] = 0xFFFFFFFF;
+            if(cu[n] < 0 || cu[n] >= span->map_width || cv[n] < 0 ||
+               cv[n] >= span->map_height) continue;
+            tile = span->layer[cv[n]*span->map_width+cu[n]];
+            if(!tile) continue;
+            tex = span->tileset[tile-1].texture;
+            texels[n] = tex->data[((fv[n]*tex->height)>>PRECISION)*tex->width+
+                                  ((fu[n]*tex->width)>>PRECISION)];
+            keep[n] = 0;
+        }
+        px = _mm_loadu_si128((__m128i*)texels);
+        lo = _mm_mullo_epi16(_mm_unpacklo_epi8(px, zero), vf);
+        hi = _mm_mullo_epi16(_mm_unpackhi_epi8(px, zero), vf);
+        px = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+        px = _mm_or_si128(px, _mm_set1_epi32(0xFF));
+        /* Leave the pixels without a tile untouched. */
+        mask = _mm_loadu_si128((__m128i*)keep);
+        px = _mm_or_si128(_mm_andnot_si128(mask, px),
+                          _mm_and_si128(mask,
+                                        _mm_loadu_si128((__m128i*)(row+x))));
+        _mm_storeu_si128((__m128i*)(row+x), px);
+    }
+    u += (x-x1)*du;
+    v += (x-x1)*dv;
 #endif
+    for(;x<x2;x++,u+=du,v+=dv){
+        cx = u>>PRECISION;
+        cy = v>>PRECISION;
+        if(cx < 0 || cx >= span->map_width || cy < 0 ||
+           cy >= span->map_height) continue;
+        tile = span->layer[cy*span->map_width+cx];
+        if(!tile) continue;
+        tex = span->tileset[tile-1].texture;
+        c = tex->data[(((v&((1<<PRECISION)-1))*tex->height)>>PRECISION)*
+                      tex->width+
+                      (((u&((1<<PRECISION)-1))*tex->width)>>PRECISION)];
+        row[x] = SHADE(c, f);
+    }
+}
+
+Pixel render_color(int r, int g, int b) {
+    return RGBA(r, g, b);
+}
+
+void render_blit(Renderer *renderer, Pixel *image, int w, int h, int x, int y,
+                 int scale, int cx, int cy, int cw, int ch) {
+    int dx, dy;
+    int sx, sy;
+    int x1, y1, x2, y2;
+    int end;
+    Pixel c;
+    Pixel *row;
+    Pixel *src;
+    if(scale < 1) return;
+    /* Clip the image to the rectangle and to the screen. */
+    x1 = x > cx ? x : cx;
+    y1 = y > cy ? y : cy;
+    x2 = x+w*scale < cx+cw ? x+w*scale : cx+cw;
+    y2 = y+h*scale < cy+ch ? y+h*scale : cy+ch;
+    if(x1 < 0) x1 = 0;
+    if(y1 < 0) y1 = 0;
+    if(x2 > renderer->w) x2 = renderer->w;
+    if(y2 > renderer->h) y2 = renderer->h;
+    for(dy=y1;dy<y2;dy++){
+        row = renderer->pixels+dy*renderer->w;
+        sy = (dy-y)/scale;
+        /* The rows that come from the same row of the image are copied. */
+        if(dy > y1 && (dy-1-y)/scale == sy){
+            memcpy(row+x1, row-renderer->w+x1, (x2-x1)*sizeof(Pixel));
+            continue;
+        }
+        src = image+sy*w;
+        for(dx=x1;dx<x2;){
+            sx = (dx-x)/scale;
+            c = src[sx];
+            end = x+(sx+1)*scale;
+            if(end > x2) end = x2;
+            for(;dx<end;dx++) row[dx] = c;
+        }
+    }
+}
+
+void render_upscale(Renderer *renderer, int w, int h) {
+    int x, y;
+    int sy;
+    int last_sy = -1;
+    unsigned int *row;
+    unsigned int *src;
+    /* Done in place from the bottom right corner, so that no pixel is
+     * overwritten before being read. Rows that come from the same source row
+     * are copied from the row that was already scaled below them. */
+    for(y=renderer->h-1;y>=0;y--){
+        sy = y*h/renderer->h;
+        row = renderer->pixels+y*renderer->w;
+        if(sy == last_sy){
+            memcpy(row, row+renderer->w, renderer->w*sizeof(unsigned int));
+            continue;
+        }
+        src = renderer->pixels+sy*renderer->w;
+        for(x=renderer->w-1;x>=0;x--){
+            row[x] = src[x*w/renderer->w];
+        }
+        last_sy = sy;
+    }
 }
 
 void render_update(Renderer *renderer) {
-    SDL_RenderFlush(renderer->renderer);
+    /* Nothing to show for a framebuffer without a window. */
+    if(!renderer->texture) return;
+    SDL_UpdateTexture(renderer->texture, NULL, renderer->pixels,
+                      renderer->w*sizeof(unsigned int));
+    SDL_RenderCopy(renderer->renderer, renderer->texture, NULL, NULL);
     SDL_RenderPresent(renderer->renderer);
 }
 
 void render_clear(Renderer *renderer, char black) {
-    SDL_SetRenderDrawColor(renderer->renderer, black ? 0x00 : 0xFF,
-                           black ? 0x00 : 0xFF, black ? 0x00 : 0xFF,
-                           SDL_ALPHA_OPAQUE);
-    SDL_RenderClear(renderer->renderer);
+    int i;
+    unsigned int c = black ? RGBA(0, 0, 0) : RGBA(0xFF, 0xFF, 0xFF);
+    for(i=0;i<renderer->w*renderer->h;i++){
+        renderer->pixels[i] = c;
+    }
 }
-
 char render_keydown(Renderer *renderer, int key) {
     Uint8 *keybuffer;
     const int keymap[KEY_AMOUNT] = {
@@ -208,12 +439,23 @@ int render_ms(Renderer *renderer) {
     return SDL_GetTicks();
 }
 
+unsigned long render_us(Renderer *renderer) {
+    (void)renderer;
+    return (unsigned long)((double)SDL_GetPerformanceCounter()*1000000/
+                           SDL_GetPerformanceFrequency());
+}
+
 void render_show_fps(Renderer *renderer) {
     /* TODO: Show the FPS in the window */
     printf("FPS: %d    \r", renderer->fps);
     fflush(stdout);
 }
 
+void render_show_text(Renderer *renderer, char *text) {
+    printf("FPS: %d    %s    \r", renderer->fps, text);
+    fflush(stdout);
+}
+
 void render_main_loop(Renderer *renderer, void (*loop_function)(int)) {
     SDL_Event event;
     int w, h;
@@ -249,6 +491,8 @@ void render_main_loop(Renderer *renderer, void (*loop_function)(int)) {
         time = time ? time : 1;
         renderer->fps = 1000/time;
     }
+    free(renderer->pixels);
+    SDL_DestroyTexture(renderer->texture);
     SDL_DestroyRenderer(renderer->renderer);
     SDL_DestroyWindow(renderer->window);
     SDL_Quit();
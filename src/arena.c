@@ -0,0 +1,128 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <arena.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* A heap block that did not fit in the arena, followed by its data. */
+typedef union Extra {
+    union Extra *next;
+    /* Keep the data after it aligned. */
+    unsigned char pad[ARENA_ALIGN];
+} Extra;
+
+#define ALIGN(size) (((size)+ARENA_ALIGN-1)/ARENA_ALIGN*ARENA_ALIGN)
+
+void arena_init(Arena *arena, size_t size) {
+    arena->data = NULL;
+    arena->size = ALIGN(size);
+    arena->used = 0;
+    arena->extra = NULL;
+    arena->extra_size = 0;
+    arena->high_water = 0;
+    arena->heap_calls = 0;
+    if(arena->size){
+        arena->data = malloc(arena->size);
+        arena->heap_calls++;
+        if(!arena->data){
+            fputs("[arena] Failed to allocate the arena!\n", stderr);
+            exit(-1);
+        }
+    }
+}
+
+void _arena_free_extra(Arena *arena) {
+    Extra *extra = arena->extra;
+    Extra *next;
+    for(;extra;extra=next){
+        next = extra->next;
+        free(extra);
+        arena->heap_calls++;
+    }
+    arena->extra = NULL;
+    arena->extra_size = 0;
+}
+
+void arena_free(Arena *arena) {
+    _arena_free_extra(arena);
+    free(arena->data);
+    arena->data = NULL;
+    arena->size = 0;
+    arena->used = 0;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    Extra *extra;
+    void *ptr;
+    size = ALIGN(size);
+    if(arena->used+size <= arena->size){
+        ptr = arena->data+arena->used;
+        arena->used += size;
+    }else{
+        extra = malloc(sizeof(Extra)+size);
+        arena->heap_calls++;
+        if(!extra){
+            fputs("[arena] Failed to allocate memory!\n", stderr);
+            exit(-1);
+        }
+        extra->next = arena->extra;
+        arena->extra = extra;
+        arena->extra_size += size;
+        ptr = extra+1;
+    }
+    if(arena->used+arena->extra_size > arena->high_water){
+        arena->high_water = arena->used+arena->extra_size;
+    }
+    return ptr;
+}
+
+void arena_reset(Arena *arena) {
+    arena->used = 0;
+    if(!arena->extra) return;
+    /* Make room for the whole of the largest frame. */
+    _arena_free_extra(arena);
+    if(arena->data){
+        free(arena->data);
+        arena->heap_calls++;
+    }
+    arena->size = arena->high_water;
+    arena->data = malloc(arena->size);
+    arena->heap_calls++;
+    if(!arena->data){
+        fputs("[arena] Failed to allocate the arena!\n", stderr);
+        exit(-1);
+    }
+}
@@ -0,0 +1,74 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/* A bump allocator for the data that only lives during a frame. Everything it
+ * allocated is released at once by arena_reset. When a frame needs more than
+ * the arena holds, the extra allocations come from the heap and the arena
+ * grows to the high water mark at the next reset, so that once the frames
+ * stop growing the arena never uses the heap again. */
+
+/* The alignment of the allocations. */
+#define ARENA_ALIGN 8
+
+typedef struct {
+    unsigned char *data;
+    size_t size;
+    size_t used;
+    /* The heap blocks of the current frame that did not fit in data. */
+    void *extra;
+    size_t extra_size;
+    /* The most memory used during a frame since arena_init. */
+    size_t high_water;
+    /* The number of times the arena called malloc or free. */
+    unsigned long heap_calls;
+} Arena;
+
+/* Create an arena of size bytes, which may be 0 to let it grow with the first
+ * frames. */
+void arena_init(Arena *arena, size_t size);
+
+void arena_free(Arena *arena);
+
+/* Allocate size bytes, aligned on ARENA_ALIGN. Never returns NULL. */
+void *arena_alloc(Arena *arena, size_t size);
+
+/* Release all the allocations. */
+void arena_reset(Arena *arena);
+
+#endif
@@ -0,0 +1,256 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* pthreads and sysconf are POSIX. */
+#define _POSIX_C_SOURCE 200809L
+
+#include <batch.h>
+
+#if BATCH
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* The state shared with the worker threads. */
+typedef struct {
+    Batch *batch;
+    pthread_t threads[BATCH_WORKERS];
+    int thread_num;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    char quit;
+    /* Incremented each time a batch starts. */
+    unsigned long generation;
+    /* The current batch. */
+    const Pose *poses;
+    BatchFrame *frames;
+    int n;
+    int next; /* The next camera to render. */
+    int running; /* Worker threads that did not finish the batch yet. */
+} Pool;
+
+typedef struct {
+    Pool *pool;
+    int worker;
+} WorkerArg;
+
+/* Render cameras of the current batch with the raycaster of worker until
+ * there are none left. */
+void _batch_work(Pool *pool, int worker) {
+    Batch *batch = pool->batch;
+    Raycaster *r = batch->raycasters+worker;
+    BatchFrame *frame;
+    int i;
+    for(;;){
+        pthread_mutex_lock(&pool->lock);
+        i = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        if(i >= pool->n) break;
+        frame = pool->frames+i;
+        render_init_pixels(batch->targets+worker, frame->pixels,
+                           batch->width, batch->height);
+        r->zbuffer = frame->depth ? frame->depth :
+                     batch->zbuffers+worker*batch->width;
+        r->x = pool->poses[i].x;
+        r->y = pool->poses[i].y;
+        r->r = pool->poses[i].r;
+        raycaster_render_world(r);
+    }
+}
+
+void *_batch_worker(void *arg) {
+    Pool *pool = ((WorkerArg*)arg)->pool;
+    int worker = ((WorkerArg*)arg)->worker;
+    unsigned long generation = 0;
+    free(arg);
+    for(;;){
+        pthread_mutex_lock(&pool->lock);
+        while(!pool->quit && pool->generation == generation){
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if(pool->quit){
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        generation = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+        _batch_work(pool, worker);
+        pthread_mutex_lock(&pool->lock);
+        if(!--pool->running) pthread_cond_signal(&pool->done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+void _batch_stop(Pool *pool) {
+    int i;
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for(i=0;i<pool->thread_num;i++) pthread_join(pool->threads[i], NULL);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool);
+}
+
+int batch_init(Batch *batch, Map *map, int width, int height,
+               int worker_num) {
+    Pool *pool;
+    WorkerArg *arg;
+    int i;
+    if(!map->data){
+        fputs("[batch] Streamed maps can't be rendered in batches!\n",
+              stderr);
+        return -1;
+    }
+    if(worker_num < 1) worker_num = sysconf(_SC_NPROCESSORS_ONLN);
+    if(worker_num < 1) worker_num = 1;
+    if(worker_num > BATCH_WORKERS) worker_num = BATCH_WORKERS;
+    batch->width = width;
+    batch->height = height;
+    batch->worker_num = worker_num;
+    batch->raycasters = malloc(worker_num*sizeof(Raycaster));
+    batch->targets = malloc(worker_num*sizeof(Renderer));
+    batch->zbuffers = malloc(worker_num*width*sizeof(fixed_t));
+    pool = malloc(sizeof(Pool));
+    if(!batch->raycasters || !batch->targets || !batch->zbuffers || !pool){
+        fputs("[batch] Failed to allocate the workers!\n", stderr);
+        exit(-1);
+    }
+    for(i=0;i<worker_num;i++){
+        render_init_pixels(batch->targets+i, NULL, width, height);
+        raycaster_init_target(batch->raycasters+i, batch->targets+i, map, 0,
+                              0, 0, batch->zbuffers+i*width);
+    }
+    batch->pool = pool;
+    pool->batch = batch;
+    pool->thread_num = 0;
+    pool->quit = 0;
+    pool->generation = 0;
+    pool->n = 0;
+    pool->next = 0;
+    pool->running = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    /* The calling thread is the worker 0. */
+    for(i=1;i<worker_num;i++){
+        arg = malloc(sizeof(WorkerArg));
+        if(!arg){
+            fputs("[batch] Failed to allocate the workers!\n", stderr);
+            exit(-1);
+        }
+        arg->pool = pool;
+        arg->worker = i;
+        if(pthread_create(pool->threads+pool->thread_num, NULL,
+                          _batch_worker, arg)){
+            fputs("[batch] Failed to start the worker threads!\n", stderr);
+            free(arg);
+            batch_free(batch);
+            return -1;
+        }
+        pool->thread_num++;
+    }
+    return 0;
+}
+
+/* Copy the settings of the first raycaster to the other ones. */
+void _batch_configure(Batch *batch) {
+    Raycaster *first = batch->raycasters;
+    Raycaster *r;
+    int i;
+    first->target_ms = 0;
+    first->incremental = 0;
+    first->reuse_rays = 0;
+    for(i=1;i<batch->worker_num;i++){
+        r = batch->raycasters+i;
+        if(r->map != first->map) raycaster_set_map(r, first->map);
+        if(r->sprites != first->sprites || r->sprite_num != first->sprite_num){
+            raycaster_set_sprites(r, first->sprites, first->sprite_num);
+        }
+        r->fov = first->fov;
+        r->rays = first->rays;
+        r->width = first->width;
+        r->len = first->len;
+        r->target_ms = 0;
+        r->strip_width = first->strip_width;
+        r->minimap = first->minimap;
+        r->texture = first->texture;
+        r->fisheye_fix = first->fisheye_fix;
+        r->floor = first->floor;
+        r->detail = first->detail;
+        r->adaptive = first->adaptive;
+        r->incremental = 0;
+        r->reuse_rays = 0;
+    }
+}
+
+void batch_render(Batch *batch, const Pose *poses, BatchFrame *frames,
+                  int n) {
+    Pool *pool = batch->pool;
+    _batch_configure(batch);
+    pthread_mutex_lock(&pool->lock);
+    pool->poses = poses;
+    pool->frames = frames;
+    pool->n = n;
+    pool->next = 0;
+    pool->running = pool->thread_num;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    _batch_work(pool, 0);
+    pthread_mutex_lock(&pool->lock);
+    while(pool->running) pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void batch_free(Batch *batch) {
+    int i;
+    if(batch->pool) _batch_stop(batch->pool);
+    for(i=0;i<batch->worker_num;i++) raycaster_free(batch->raycasters+i);
+    free(batch->raycasters);
+    free(batch->targets);
+    free(batch->zbuffers);
+    batch->pool = NULL;
+    batch->raycasters = NULL;
+    batch->targets = NULL;
+    batch->zbuffers = NULL;
+    batch->worker_num = 0;
+}
+
+#endif
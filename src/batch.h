@@ -0,0 +1,91 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <config.h>
+
+#if BATCH
+
+#include <raycaster.h>
+
+/* Render the views of many cameras in one call, for example to produce the
+ * observations of many agents at once. The cameras are shared between worker
+ * threads, each one rendering with its own raycaster into the framebuffers of
+ * the caller. The map and its textures are only read, so the map must not be
+ * modified while rendering, and it can't be streamed (see chunkmap.h). */
+
+/* Maximum number of worker threads. */
+#define BATCH_WORKERS 64
+
+typedef struct {
+    fixed_t x, y, r;
+} Pose;
+
+/* A framebuffer owned by the caller. */
+typedef struct {
+    Pixel *pixels; /* width*height pixels, row by row. */
+    /* The distance of the wall in each of the width columns, or NULL. */
+    fixed_t *depth;
+} BatchFrame;
+
+typedef struct {
+    int width, height;
+    int worker_num;
+    /* One raycaster per worker. The settings of raycasters[0] are copied to
+     * the other ones before rendering, except incremental, reuse_rays and
+     * target_ms which are always off as the frames are unrelated. */
+    Raycaster *raycasters;
+    Renderer *targets;
+    fixed_t *zbuffers;
+    void *pool;
+} Batch;
+
+/* Prepare to render frames of width by height pixels of map with worker_num
+ * threads, including the calling thread (0 for one per processor). Returns 0
+ * on success, prints an error and returns -1 on failure, e.g. if map is
+ * streamed. */
+int batch_init(Batch *batch, Map *map, int width, int height,
+               int worker_num);
+
+/* Render the view of poses[i] into frames[i] for i from 0 to n-1, and return
+ * when they are all rendered. */
+void batch_render(Batch *batch, const Pose *poses, BatchFrame *frames, int n);
+
+void batch_free(Batch *batch);
+
+#endif
+
+#endif
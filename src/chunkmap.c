@@ -0,0 +1,404 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* pthreads, pread, open and clock_gettime are POSIX. */
+#define _POSIX_C_SOURCE 200809L
+
+#include <chunkmap.h>
+
+#if CHUNKMAP
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+#define NO_CHUNK ((unsigned long)-1)
+
+/* The state shared with the loading thread. */
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    char quit;
+    /* The chunks to load. */
+    unsigned long queue[CHUNKMAP_QUEUE];
+    int queue_start;
+    int queue_len;
+    /* The chunks that were loaded, data is NULL if it failed. */
+    unsigned long done[CHUNKMAP_QUEUE];
+    unsigned char *done_data[CHUNKMAP_QUEUE];
+    int done_num;
+    /* Copied from the ChunkMap, which the thread never reads. */
+    int fd;
+    unsigned long offset;
+    int bytes;
+} Loader;
+
+unsigned long _chunkmap_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1000000UL+ts.tv_nsec/1000;
+}
+
+/* Read a chunk into a new buffer. Returns NULL on failure. */
+unsigned char *_chunkmap_read(int fd, unsigned long offset, int bytes,
+                              unsigned long index) {
+    unsigned char *data = malloc(bytes);
+    off_t pos = (off_t)offset+(off_t)index*bytes;
+    ssize_t n;
+    int done;
+    if(!data) return NULL;
+    for(done=0;done<bytes;done+=n){
+        n = pread(fd, data+done, bytes-done, pos+done);
+        if(n <= 0){
+            free(data);
+            return NULL;
+        }
+    }
+    return data;
+}
+
+void *_chunkmap_loader(void *arg) {
+    Loader *loader = arg;
+    unsigned long index;
+    unsigned char *data;
+    pthread_mutex_lock(&loader->lock);
+    for(;;){
+        while(!loader->quit && !loader->queue_len){
+            pthread_cond_wait(&loader->cond, &loader->lock);
+        }
+        if(loader->quit) break;
+        index = loader->queue[loader->queue_start];
+        loader->queue_start = (loader->queue_start+1)%CHUNKMAP_QUEUE;
+        loader->queue_len--;
+        pthread_mutex_unlock(&loader->lock);
+        data = _chunkmap_read(loader->fd, loader->offset, loader->bytes,
+                              index);
+        pthread_mutex_lock(&loader->lock);
+        /* There are never more than CHUNKMAP_QUEUE chunks pending. */
+        loader->done[loader->done_num] = index;
+        loader->done_data[loader->done_num] = data;
+        loader->done_num++;
+    }
+    pthread_mutex_unlock(&loader->lock);
+    return NULL;
+}
+
+int chunkmap_open(ChunkMap *chunks, const char *path, unsigned long offset,
+                  int width, int height, int size, int budget) {
+    int i;
+    Loader *loader;
+    memset(chunks, 0, sizeof(ChunkMap));
+    chunks->fd = -1;
+    if(size < 1 || (size&(size-1)) || budget < 1){
+        fprintf(stderr, "[chunkmap] Invalid chunk size or budget!\n");
+        return -1;
+    }
+    while(1<<chunks->shift < size) chunks->shift++;
+    chunks->offset = offset;
+    chunks->width = width;
+    chunks->height = height;
+    chunks->chunks_w = (width+size-1)>>chunks->shift;
+    chunks->chunks_h = (height+size-1)>>chunks->shift;
+    chunks->budget = budget;
+    chunks->max_tile = 255;
+    chunks->last_index = NO_CHUNK;
+    chunks->chunk_max = budget;
+    chunks->bucket_num = budget*2;
+    chunks->chunks = malloc(chunks->chunk_max*sizeof(Chunk));
+    chunks->buckets = malloc(chunks->bucket_num*sizeof(int));
+    loader = malloc(sizeof(Loader));
+    chunks->loader = loader;
+    if(!chunks->chunks || !chunks->buckets || !loader){
+        fprintf(stderr, "[chunkmap] Failed to allocate the chunks!\n");
+        chunkmap_close(chunks);
+        return -1;
+    }
+    for(i=0;i<chunks->bucket_num;i++) chunks->buckets[i] = -1;
+    chunks->fd = open(path, O_RDONLY);
+    if(chunks->fd < 0){
+        fprintf(stderr, "[chunkmap] %s: Failed to open the file!\n", path);
+        free(loader);
+        chunks->loader = NULL;
+        chunkmap_close(chunks);
+        return -1;
+    }
+    memset(loader, 0, sizeof(Loader));
+    loader->fd = chunks->fd;
+    loader->offset = offset;
+    loader->bytes = size*size;
+    pthread_mutex_init(&loader->lock, NULL);
+    pthread_cond_init(&loader->cond, NULL);
+    if(pthread_create(&loader->thread, NULL, _chunkmap_loader, loader)){
+        fprintf(stderr, "[chunkmap] Failed to start the loading thread!\n");
+        pthread_mutex_destroy(&loader->lock);
+        pthread_cond_destroy(&loader->cond);
+        free(loader);
+        chunks->loader = NULL;
+        chunkmap_close(chunks);
+        return -1;
+    }
+    return 0;
+}
+
+void chunkmap_close(ChunkMap *chunks) {
+    int i;
+    Loader *loader = chunks->loader;
+    if(loader){
+        pthread_mutex_lock(&loader->lock);
+        loader->quit = 1;
+        pthread_cond_signal(&loader->cond);
+        pthread_mutex_unlock(&loader->lock);
+        pthread_join(loader->thread, NULL);
+        for(i=0;i<loader->done_num;i++) free(loader->done_data[i]);
+        pthread_mutex_destroy(&loader->lock);
+        pthread_cond_destroy(&loader->cond);
+        free(loader);
+    }
+    if(chunks->chunks){
+        for(i=0;i<chunks->chunk_num;i++) free(chunks->chunks[i].data);
+    }
+    free(chunks->chunks);
+    free(chunks->buckets);
+    if(chunks->fd >= 0) close(chunks->fd);
+    memset(chunks, 0, sizeof(ChunkMap));
+    chunks->fd = -1;
+}
+
+int _chunkmap_find(ChunkMap *chunks, unsigned long index) {
+    int i = chunks->buckets[index%chunks->bucket_num];
+    while(i >= 0 && chunks->chunks[i].index != index){
+        i = chunks->chunks[i].next;
+    }
+    return i;
+}
+
+void _chunkmap_unlink(ChunkMap *chunks, int n) {
+    int *i = chunks->buckets+chunks->chunks[n].index%chunks->bucket_num;
+    while(*i != n) i = &chunks->chunks[*i].next;
+    *i = chunks->chunks[n].next;
+}
+
+/* The least recently used chunk that can be evicted, or -1. */
+int _chunkmap_lru(ChunkMap *chunks) {
+    int i;
+    int lru = -1;
+    for(i=0;i<chunks->chunk_num;i++){
+        if(chunks->chunks[i].modified) continue;
+        if(lru < 0 || chunks->chunks[i].used < chunks->chunks[lru].used){
+            lru = i;
+        }
+    }
+    return lru;
+}
+
+/* Add a loaded chunk, in place of the least recently used one if the budget
+ * is reached. The budget is exceeded rather than evicting modified chunks. */
+void _chunkmap_install(ChunkMap *chunks, unsigned long index,
+                       unsigned char *data) {
+    int i = -1;
+    int n;
+    Chunk *chunk;
+    /* Remove the tiles that are not in the tileset. */
+    for(n=0;n<1<<(chunks->shift*2);n++){
+        if(data[n] > chunks->max_tile) data[n] = 0;
+    }
+    if(chunks->chunk_num >= chunks->budget) i = _chunkmap_lru(chunks);
+    if(i >= 0){
+        _chunkmap_unlink(chunks, i);
+        if(chunks->last_index == chunks->chunks[i].index){
+            chunks->last_index = NO_CHUNK;
+        }
+        free(chunks->chunks[i].data);
+        chunks->stats.evicted++;
+    }else{
+        if(chunks->chunk_num >= chunks->chunk_max){
+            chunk = realloc(chunks->chunks,
+                            chunks->chunk_max*2*sizeof(Chunk));
+            if(!chunk){
+                fputs("[chunkmap] Failed to allocate the chunks!", stderr);
+                exit(-1);
+            }
+            chunks->chunks = chunk;
+            chunks->chunk_max *= 2;
+        }
+        i = chunks->chunk_num++;
+    }
+    chunk = chunks->chunks+i;
+    chunk->index = index;
+    chunk->data = data;
+    chunk->used = chunks->frame;
+    chunk->modified = 0;
+    chunk->next = chunks->buckets[index%chunks->bucket_num];
+    chunks->buckets[index%chunks->bucket_num] = i;
+}
+
+/* Make index the last used chunk, loading it if needed. */
+void _chunkmap_select(ChunkMap *chunks, unsigned long index) {
+    int i = _chunkmap_find(chunks, index);
+    unsigned long start;
+    unsigned char *data;
+    if(i < 0){
+        start = _chunkmap_us();
+        data = _chunkmap_read(chunks->fd, chunks->offset,
+                              1<<(chunks->shift*2), index);
+        if(!data){
+            fputs("[chunkmap] Failed to load a chunk!", stderr);
+            exit(-1);
+        }
+        _chunkmap_install(chunks, index, data);
+        chunks->stats.stall_us += _chunkmap_us()-start;
+        i = _chunkmap_find(chunks, index);
+    }
+    chunks->chunks[i].used = chunks->frame;
+    chunks->last_index = index;
+    chunks->last_data = chunks->chunks[i].data;
+}
+
+int chunkmap_get(ChunkMap *chunks, int x, int y) {
+    int mask = (1<<chunks->shift)-1;
+    unsigned long index = (unsigned long)(y>>chunks->shift)*chunks->chunks_w+
+                          (x>>chunks->shift);
+    if(index == chunks->last_index || _chunkmap_find(chunks, index) >= 0){
+        chunks->stats.hits++;
+    }else{
+        chunks->stats.misses++;
+    }
+    if(index != chunks->last_index) _chunkmap_select(chunks, index);
+    return chunks->last_data[((y&mask)<<chunks->shift)+(x&mask)];
+}
+
+void chunkmap_set(ChunkMap *chunks, int x, int y, unsigned char tile) {
+    int mask = (1<<chunks->shift)-1;
+    unsigned long index = (unsigned long)(y>>chunks->shift)*chunks->chunks_w+
+                          (x>>chunks->shift);
+    if(index != chunks->last_index) _chunkmap_select(chunks, index);
+    chunks->last_data[((y&mask)<<chunks->shift)+(x&mask)] = tile;
+    chunks->chunks[_chunkmap_find(chunks, index)].modified = 1;
+}
+
+/* Ask the thread to load a chunk if it isn't loaded or being loaded. */
+void _chunkmap_request(ChunkMap *chunks, unsigned long index) {
+    int i;
+    int lru;
+    Loader *loader = chunks->loader;
+    if(chunks->pending_num >= CHUNKMAP_QUEUE) return;
+    if(_chunkmap_find(chunks, index) >= 0) return;
+    for(i=0;i<chunks->pending_num;i++){
+        if(chunks->pending[i] == index) return;
+    }
+    /* Don't evict chunks that are still in use to prefetch others. */
+    if(chunks->chunk_num+chunks->pending_num >= chunks->budget){
+        lru = _chunkmap_lru(chunks);
+        if(lru < 0 || chunks->chunks[lru].used+1 >= chunks->frame) return;
+    }
+    chunks->pending[chunks->pending_num++] = index;
+    pthread_mutex_lock(&loader->lock);
+    loader->queue[(loader->queue_start+loader->queue_len)%CHUNKMAP_QUEUE] =
+        index;
+    loader->queue_len++;
+    pthread_cond_signal(&loader->cond);
+    pthread_mutex_unlock(&loader->lock);
+}
+
+void _chunkmap_request_area(ChunkMap *chunks, int x, int y, int radius) {
+    int cx, cy;
+    int x1 = x-radius < 0 ? 0 : (x-radius)>>chunks->shift;
+    int y1 = y-radius < 0 ? 0 : (y-radius)>>chunks->shift;
+    int x2 = x+radius < 0 ? -1 : (x+radius)>>chunks->shift;
+    int y2 = y+radius < 0 ? -1 : (y+radius)>>chunks->shift;
+    if(x2 >= chunks->chunks_w) x2 = chunks->chunks_w-1;
+    if(y2 >= chunks->chunks_h) y2 = chunks->chunks_h-1;
+    for(cy=y1;cy<=y2;cy++){
+        for(cx=x1;cx<=x2;cx++){
+            _chunkmap_request(chunks,
+                              (unsigned long)cy*chunks->chunks_w+cx);
+        }
+    }
+}
+
+void chunkmap_update(ChunkMap *chunks, int x, int y, int ahead_x, int ahead_y,
+                     int radius) {
+    int i, n;
+    int done_num;
+    unsigned long done[CHUNKMAP_QUEUE];
+    unsigned char *done_data[CHUNKMAP_QUEUE];
+    Loader *loader = chunks->loader;
+    chunks->frame++;
+    /* The last chunk may have been used without being selected again. */
+    if(chunks->last_index != NO_CHUNK){
+        i = _chunkmap_find(chunks, chunks->last_index);
+        if(i >= 0) chunks->chunks[i].used = chunks->frame;
+    }
+    pthread_mutex_lock(&loader->lock);
+    done_num = loader->done_num;
+    memcpy(done, loader->done, done_num*sizeof(unsigned long));
+    memcpy(done_data, loader->done_data, done_num*sizeof(unsigned char*));
+    loader->done_num = 0;
+    pthread_mutex_unlock(&loader->lock);
+    for(i=0;i<done_num;i++){
+        for(n=0;n<chunks->pending_num;n++){
+            if(chunks->pending[n] == done[i]){
+                chunks->pending[n] = chunks->pending[--chunks->pending_num];
+                break;
+            }
+        }
+        if(!done_data[i]) continue;
+        /* It may have been needed before the thread loaded it. */
+        if(_chunkmap_find(chunks, done[i]) >= 0){
+            free(done_data[i]);
+            continue;
+        }
+        _chunkmap_install(chunks, done[i], done_data[i]);
+        chunks->stats.prefetched++;
+    }
+    _chunkmap_request_area(chunks, x, y, radius);
+    _chunkmap_request_area(chunks, ahead_x, ahead_y, radius);
+}
+
+void chunkmap_format(ChunkMap *chunks, char *buf) {
+    unsigned long total = chunks->stats.hits+chunks->stats.misses;
+    sprintf(buf, "chunks: %d/%d hits: %lu.%lu%% misses: %lu stall: %luus "
+            "prefetched: %lu evicted: %lu", chunks->chunk_num, chunks->budget,
+            total ? chunks->stats.hits*100/total : 0,
+            total ? chunks->stats.hits*1000/total%10 : 0,
+            chunks->stats.misses, chunks->stats.stall_us,
+            chunks->stats.prefetched, chunks->stats.evicted);
+}
+
+#endif
@@ -0,0 +1,126 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CHUNKMAP_H
+#define CHUNKMAP_H
+
+#include <config.h>
+
+/* A layer of tiles streamed from a file by chunks of size by size cells. The
+ * chunks are stored one after the other, row by row, and their cells too.
+ * At most budget chunks are kept in memory, the least recently used chunk is
+ * evicted to load a new one. A thread loads the chunks around the camera
+ * before they are needed. Only chunkmap_update talks to this thread, so the
+ * other functions don't lock anything, but they must all be called from the
+ * same thread. */
+
+/* Default chunk size in cells, and default budget in chunks. */
+#define CHUNKMAP_SIZE 64
+#define CHUNKMAP_BUDGET 64
+
+/* Maximum number of chunks waiting to be loaded by the thread. */
+#define CHUNKMAP_QUEUE 32
+
+/* The size of the buffer passed to chunkmap_format. */
+#define CHUNKMAP_TEXT_MAX 192
+
+typedef struct {
+    /* Tiles found in a chunk that was already in memory. */
+    unsigned long hits;
+    /* Tiles that needed their chunk to be loaded right away. */
+    unsigned long misses;
+    /* Time spent waiting for these chunks in microseconds. */
+    unsigned long stall_us;
+    /* Chunks loaded in advance by the thread. */
+    unsigned long prefetched;
+    unsigned long evicted;
+} ChunkStats;
+
+typedef struct {
+    unsigned long index; /* Index of the chunk in the file. */
+    unsigned char *data;
+    unsigned long used; /* The frame in which it was last used. */
+    char modified; /* Modified chunks are never evicted. */
+    int next; /* Next chunk in the same bucket of the hash table, or -1. */
+} Chunk;
+
+typedef struct ChunkMap {
+    int fd;
+    unsigned long offset; /* Offset of the first chunk in the file. */
+    int width, height; /* Size of the layer in cells. */
+    int shift; /* The chunk size is 1<<shift. */
+    int chunks_w, chunks_h;
+    int budget;
+    int max_tile; /* Bigger tiles are replaced by 0 when loading a chunk. */
+    /* The chunks in memory. */
+    Chunk *chunks;
+    int chunk_num;
+    int chunk_max;
+    int *buckets; /* First chunk of each bucket, or -1. */
+    int bucket_num;
+    unsigned long frame;
+    /* The chunk that was used last. */
+    unsigned long last_index;
+    unsigned char *last_data;
+    /* The chunks requested to the thread and not installed yet. */
+    unsigned long pending[CHUNKMAP_QUEUE];
+    int pending_num;
+    void *loader;
+    ChunkStats stats;
+} ChunkMap;
+
+/* Open the layer of width by height cells stored at offset in the file at
+ * path, by chunks of size by size cells (a power of two). Returns 0 on
+ * success, prints an error and returns -1 on failure. */
+int chunkmap_open(ChunkMap *chunks, const char *path, unsigned long offset,
+                  int width, int height, int size, int budget);
+
+void chunkmap_close(ChunkMap *chunks);
+
+/* Get the tile at x, y, which has to be inside of the layer. */
+int chunkmap_get(ChunkMap *chunks, int x, int y);
+
+void chunkmap_set(ChunkMap *chunks, int x, int y, unsigned char tile);
+
+/* Install the chunks loaded by the thread and ask it to load the chunks
+ * within radius cells of x, y and of ahead_x, ahead_y. Should be called once
+ * per frame. */
+void chunkmap_update(ChunkMap *chunks, int x, int y, int ahead_x, int ahead_y,
+                     int radius);
+
+/* Write a single line with the stats into buf (which should be at least
+ * CHUNKMAP_TEXT_MAX bytes long). */
+void chunkmap_format(ChunkMap *chunks, char *buf);
+
+#endif
@@ -0,0 +1,216 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <entity.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+void entities_init(Entities *entities, int max) {
+    linit();
+    entities->x = malloc(max*sizeof(fixed_t));
+    entities->y = malloc(max*sizeof(fixed_t));
+    entities->vx = malloc(max*sizeof(fixed_t));
+    entities->vy = malloc(max*sizeof(fixed_t));
+    entities->radius = malloc(max*sizeof(fixed_t));
+    entities->sprite = malloc(max*sizeof(Sprite*));
+    if(!entities->x || !entities->y || !entities->vx || !entities->vy ||
+       !entities->radius || !entities->sprite){
+        fputs("[entity] Failed to allocate the entities!\n", stderr);
+        exit(-1);
+    }
+    entities->num = 0;
+    entities->max = max;
+}
+
+void entities_free(Entities *entities) {
+    free(entities->x);
+    free(entities->y);
+    free(entities->vx);
+    free(entities->vy);
+    free(entities->radius);
+    free(entities->sprite);
+    entities->x = NULL;
+    entities->y = NULL;
+    entities->vx = NULL;
+    entities->vy = NULL;
+    entities->radius = NULL;
+    entities->sprite = NULL;
+    entities->num = 0;
+    entities->max = 0;
+}
+
+int entities_add(Entities *entities, fixed_t x, fixed_t y, fixed_t radius,
+                 Sprite *sprite) {
+    int i = entities->num;
+    if(i >= entities->max) return -1;
+    entities->x[i] = x;
+    entities->y[i] = y;
+    entities->vx[i] = 0;
+    entities->vy[i] = 0;
+    entities->radius[i] = radius;
+    entities->sprite[i] = sprite;
+    if(sprite){
+        sprite->x = x;
+        sprite->y = y;
+    }
+    entities->num++;
+    return i;
+}
+
+char _entity_solid(Map *map, int x, int y) {
+    if(x < 0 || x >= map->width || y < 0 || y >= map->height) return 1;
+    return MAP_TILE(map, x, y) != 0;
+}
+
+/* Push the circle at *x, *y out of the walls it overlaps, after it moved by
+ * sx, sy. Adds the axes along which it was pushed out of a face to *hit, and
+ * returns 0 if it overlapped no wall. */
+int _entity_push(Map *map, fixed_t *x, fixed_t *y, fixed_t radius,
+                 fixed_t sx, fixed_t sy, int *hit) {
+    int cx, cy;
+    int x1 = TO_INT(*x-radius), x2 = TO_INT(*x+radius);
+    int y1 = TO_INT(*y-radius), y2 = TO_INT(*y+radius);
+    int pushed = 0;
+    fixed_t nx, ny;
+    fixed_t dx, dy;
+    fixed_t d;
+    for(cy=y1;cy<=y2;cy++){
+        for(cx=x1;cx<=x2;cx++){
+            if(!_entity_solid(map, cx, cy)) continue;
+            /* The point of the cell that is the nearest to the center. */
+            nx = *x < TO_FIXED(cx) ? TO_FIXED(cx) :
+                 *x > TO_FIXED(cx+1) ? TO_FIXED(cx+1) : *x;
+            ny = *y < TO_FIXED(cy) ? TO_FIXED(cy) :
+                 *y > TO_FIXED(cy+1) ? TO_FIXED(cy+1) : *y;
+            dx = *x-nx;
+            dy = *y-ny;
+            if(dx && dy){
+                /* A corner. */
+                d = MUL(dx, dx)+MUL(dy, dy);
+                if(d >= MUL(radius, radius)) continue;
+                d = SQRT(d);
+                if(!d) continue;
+                /* Slide around it, without stopping along an axis. */
+                *x = nx+DIV(MUL(dx, radius), d);
+                *y = ny+DIV(MUL(dy, radius), d);
+                pushed = 1;
+            }else if(dx){
+                if(ABS(dx) >= radius) continue;
+                *x = nx+(dx > 0 ? radius : -radius);
+                *hit |= ENTITY_HIT_X;
+                pushed = 1;
+            }else if(dy){
+                if(ABS(dy) >= radius) continue;
+                *y = ny+(dy > 0 ? radius : -radius);
+                *hit |= ENTITY_HIT_Y;
+                pushed = 1;
+            }else if(sx){
+                /* The center is in the cell, go back out of it. */
+                *x = sx > 0 ? TO_FIXED(cx)-radius : TO_FIXED(cx+1)+radius;
+                *hit |= ENTITY_HIT_X;
+                pushed = 1;
+            }else if(sy){
+                *y = sy > 0 ? TO_FIXED(cy)-radius : TO_FIXED(cy+1)+radius;
+                *hit |= ENTITY_HIT_Y;
+                pushed = 1;
+            }
+        }
+    }
+    return pushed;
+}
+
+/* Move the circle by sx, sy and push it until it doesn't overlap any wall, as
+ * getting out of a wall can push it into another one. If it still overlaps
+ * one (e.g. between two walls touching by a corner), the move is undone. */
+void _entity_step(Map *map, fixed_t *x, fixed_t *y, fixed_t radius,
+                  fixed_t sx, fixed_t sy, int *hit) {
+    int i;
+    fixed_t old_x = *x;
+    fixed_t old_y = *y;
+    *x += sx;
+    *y += sy;
+    for(i=0;i<ENTITY_ITERATIONS;i++){
+        if(!_entity_push(map, x, y, radius, sx, sy, hit)) return;
+    }
+    if(!_entity_push(map, x, y, radius, sx, sy, hit) &&
+       !_entity_solid(map, TO_INT(*x), TO_INT(*y))) return;
+    *x = old_x;
+    *y = old_y;
+    *hit |= sx ? ENTITY_HIT_X : ENTITY_HIT_Y;
+}
+
+int entity_move(Map *map, fixed_t *x, fixed_t *y, fixed_t radius, fixed_t dx,
+                fixed_t dy) {
+    fixed_t step = radius > 0 && radius < TO_FIXED(1)/2 ? radius :
+                   TO_FIXED(1)/2;
+    fixed_t sx, sy;
+    int n;
+    int hit = 0;
+    n = (ABS(dx) > ABS(dy) ? ABS(dx) : ABS(dy))/step+1;
+    sx = dx/n;
+    sy = dy/n;
+    /* Move along each axis separately, so that the circle slides along the
+     * walls. The remainder of the division goes in the last step. */
+    for(;n>0;n--){
+        if(n == 1){
+            sx = dx;
+            sy = dy;
+        }
+        if(sx) _entity_step(map, x, y, radius, sx, 0, &hit);
+        if(sy) _entity_step(map, x, y, radius, 0, sy, &hit);
+        dx -= sx;
+        dy -= sy;
+    }
+    return hit;
+}
+
+void entities_update(Entities *entities, Map *map, fixed_t dt) {
+    int i;
+    int hit;
+    for(i=0;i<entities->num;i++){
+        if(entities->vx[i] || entities->vy[i]){
+            hit = entity_move(map, entities->x+i, entities->y+i,
+                              entities->radius[i],
+                              MUL(entities->vx[i], dt),
+                              MUL(entities->vy[i], dt));
+            if(hit & ENTITY_HIT_X) entities->vx[i] = 0;
+            if(hit & ENTITY_HIT_Y) entities->vy[i] = 0;
+        }
+        if(entities->sprite[i]){
+            entities->sprite[i]->x = entities->x[i];
+            entities->sprite[i]->y = entities->y[i];
+        }
+    }
+}
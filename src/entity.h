@@ -0,0 +1,89 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ENTITY_H
+#define ENTITY_H
+
+#include <fixed.h>
+#include <map.h>
+
+/* Entities moving on the map, colliding with the walls as circles. They are
+ * stored field by field, so that entities_update goes through each array in
+ * order. An entity can be linked to a sprite, whose position is updated with
+ * the one of the entity, so that it is drawn by the sprite pass. */
+
+/* The maximum number of times a circle is pushed out of the walls after each
+ * step of a move. */
+#define ENTITY_ITERATIONS 4
+
+/* The axes along which entity_move pushed a circle out of the face of a
+ * wall. */
+enum {
+    ENTITY_HIT_X = 1,
+    ENTITY_HIT_Y = 2
+};
+
+typedef struct {
+    fixed_t *x, *y;
+    fixed_t *vx, *vy; /* In cells per second. */
+    fixed_t *radius;
+    Sprite **sprite; /* NULL if the entity has no sprite. */
+    int num;
+    int max;
+} Entities;
+
+/* Allocate the arrays for at most max entities. */
+void entities_init(Entities *entities, int max);
+
+void entities_free(Entities *entities);
+
+/* Add an entity at x, y, not moving. Returns its index, or -1 if there are
+ * already max entities. */
+int entities_add(Entities *entities, fixed_t x, fixed_t y, fixed_t radius,
+                 Sprite *sprite);
+
+/* Move the entities by their velocity during dt seconds, sliding along the
+ * walls. The velocity along an axis where an entity hit a wall is set to 0. */
+void entities_update(Entities *entities, Map *map, fixed_t dt);
+
+/* Move the circle of radius radius at *x, *y by dx, dy, sliding along the
+ * walls. The move is split in steps shorter than the radius (and than half a
+ * cell), so that the circle can't go through a wall. Everything outside of
+ * the map is a wall. Needs the lookup tables of fixed.h, initialized by
+ * linit (called by entities_init and raycaster_init). Returns a combination
+ * of ENTITY_HIT_X and ENTITY_HIT_Y. */
+int entity_move(Map *map, fixed_t *x, fixed_t *y, fixed_t radius, fixed_t dx,
+                fixed_t dy);
+
+#endif
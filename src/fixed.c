@@ -99,9 +99,11 @@ fixed_t _lut_sqrt_big[SQRT_LUT_BIG_MAX];
 fixed_t _lut_sin[360];
 fixed_t _lut_div[DIV_LUT_MAX];
 ufixed_t _lut_udiv[DIV_LUT_MAX];
+char _lut_ready = 0;
 
 void linit(void) {
     fixed_t i;
+    if(_lut_ready) return;
     /* Initialize the sqrt LUT (for small numbers) */
     for(i=0;i<TO_FIXED(SQRT_LUT_MAX);i++){
         _lut_sqrt[i] = fsqrt(i);
@@ -123,6 +125,7 @@ void linit(void) {
     for(i=1;i<DIV_LUT_MAX;i++){
         _lut_udiv[i] = UTO_FIXED(1)/i;
     }
+    _lut_ready = 1;
 }
 
 fixed_t lsqrt(fixed_t x) {
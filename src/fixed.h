@@ -148,7 +148,9 @@ fixed_t datan2(fixed_t x, fixed_t y);
  */
 fixed_t fsqrt(fixed_t n);
 
-/* Math functions using lookup tables. linit initalizes the lookup tables. */
+/* Math functions using lookup tables. linit initalizes the lookup tables the
+ * first time it is called. They are only read after that, so several threads
+ * can use them, once the first call returned. */
 void linit(void);
 
 fixed_t lsqrt(fixed_t x);
@@ -0,0 +1,353 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <flowfield.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* The step of each direction. */
+const signed char _flow_dx[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+const signed char _flow_dy[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+void _flow_alloc_failed(void) {
+    fputs("[flowfield] Failed to allocate the field!\n", stderr);
+    exit(-1);
+}
+
+void flowfield_init(FlowField *field, Map *map) {
+    int i;
+    field->map = map;
+    field->width = map->width;
+    field->height = map->height;
+    field->dist = malloc(map->width*map->height*sizeof(unsigned int));
+    field->dir = malloc(map->width*map->height);
+    if(!field->dist || !field->dir) _flow_alloc_failed();
+    for(i=0;i<map->width*map->height;i++){
+        field->dist[i] = FLOW_UNREACHABLE;
+        field->dir[i] = FLOW_NONE;
+    }
+    field->goals = NULL;
+    field->goal_num = 0;
+    for(i=0;i<=FLOW_DIAGONAL;i++){
+        field->buckets[i] = NULL;
+        field->bucket_len[i] = 0;
+        field->bucket_max[i] = 0;
+    }
+    field->stack = NULL;
+    field->stack_max = 0;
+    field->seeds = NULL;
+    field->seed_max = 0;
+}
+
+void flowfield_free(FlowField *field) {
+    int i;
+    free(field->dist);
+    free(field->dir);
+    free(field->goals);
+    for(i=0;i<=FLOW_DIAGONAL;i++){
+        free(field->buckets[i]);
+        field->buckets[i] = NULL;
+        field->bucket_max[i] = 0;
+    }
+    free(field->stack);
+    free(field->seeds);
+    field->dist = NULL;
+    field->dir = NULL;
+    field->goals = NULL;
+    field->stack = NULL;
+    field->seeds = NULL;
+    field->stack_max = 0;
+    field->seed_max = 0;
+}
+
+/* Make *array big enough for n items of size bytes. */
+void _flow_reserve(void **array, int *max, int n, int size) {
+    void *new;
+    if(n <= *max) return;
+    new = realloc(*array, (n > *max*2 ? n : *max*2)*size);
+    if(!new) _flow_alloc_failed();
+    *array = new;
+    *max = n > *max*2 ? n : *max*2;
+}
+
+char _flow_open(FlowField *field, int x, int y) {
+    if(x < 0 || x >= field->width || y < 0 || y >= field->height) return 0;
+    return !MAP_TILE(field->map, x, y);
+}
+
+/* The moves possible from the cell at x, y, bit d being set if it can move in
+ * the direction d. */
+int _flow_moves(FlowField *field, int x, int y) {
+    int d;
+    int open = 0;
+    int moves;
+    unsigned char *tiles;
+    if(field->map->data && x > 0 && x < field->width-1 && y > 0 &&
+       y < field->height-1){
+        /* Away from the borders of the map, read the tiles directly. */
+        tiles = field->map->data+y*field->width+x;
+        for(d=0;d<8;d++){
+            open |= !tiles[_flow_dy[d]*field->width+_flow_dx[d]]<<d;
+        }
+    }else{
+        for(d=0;d<8;d++){
+            open |= _flow_open(field, x+_flow_dx[d], y+_flow_dy[d])<<d;
+        }
+    }
+    /* Don't cut the corners: a diagonal move needs the orthogonal moves on
+     * both sides of it. */
+    moves = open&0x55;
+    moves |= open&(open<<1)&(open>>1|open<<7)&0xAA;
+    return moves;
+}
+
+void _flow_push(FlowField *field, int cell, unsigned int dist) {
+    int b = dist%(FLOW_DIAGONAL+1);
+    _flow_reserve((void**)&field->buckets[b], &field->bucket_max[b],
+                  field->bucket_len[b]+1, sizeof(int));
+    field->buckets[b][field->bucket_len[b]++] = cell;
+}
+
+int _flow_compare_seeds(const void *item1, const void *item2) {
+    const FlowSeed *seed1 = item1;
+    const FlowSeed *seed2 = item2;
+    if(seed1->dist < seed2->dist) return -1;
+    return seed1->dist > seed2->dist;
+}
+
+/* Propagate the distances from the n seeds with Dial's algorithm: the
+ * distances of the cells waiting to be processed are at most FLOW_DIAGONAL
+ * apart, so there is a bucket for each of them. The seeds are added to the
+ * buckets when their distance is reached. */
+void _flow_propagate(FlowField *field, int n) {
+    int s = 0;
+    int b;
+    int d;
+    int cell, next;
+    int moves;
+    int waiting = 0;
+    unsigned int dist, new_dist;
+    qsort(field->seeds, n, sizeof(FlowSeed), _flow_compare_seeds);
+    if(!n) return;
+    dist = field->seeds[0].dist;
+    while(waiting || s < n){
+        if(!waiting && field->seeds[s].dist > dist){
+            dist = field->seeds[s].dist;
+        }
+        for(;s<n && field->seeds[s].dist == dist;s++){
+            _flow_push(field, field->seeds[s].cell, dist);
+            waiting++;
+        }
+        b = dist%(FLOW_DIAGONAL+1);
+        /* The cells reached from this bucket go to other buckets, as
+         * FLOW_STRAIGHT and FLOW_DIAGONAL are smaller than the number of
+         * buckets. */
+        while(field->bucket_len[b]){
+            cell = field->buckets[b][--field->bucket_len[b]];
+            waiting--;
+            /* Skip the cells that got a smaller distance after this one
+             * was added. */
+            if(field->dist[cell] != dist) continue;
+            moves = _flow_moves(field, cell%field->width,
+                                cell/field->width);
+            for(d=0;d<8;d++){
+                if(!(moves>>d&1)) continue;
+                next = cell+_flow_dy[d]*field->width+_flow_dx[d];
+                new_dist = dist+(d&1 ? FLOW_DIAGONAL : FLOW_STRAIGHT);
+                if(new_dist < field->dist[next]){
+                    field->dist[next] = new_dist;
+                    field->dir[next] = (d+4)&7;
+                    _flow_push(field, next, new_dist);
+                    waiting++;
+                }
+            }
+        }
+        dist++;
+    }
+}
+
+void flowfield_build(FlowField *field, const int *goals_x, const int *goals_y,
+                     int n) {
+    int i;
+    int cell;
+    int num = 0;
+    for(i=0;i<field->width*field->height;i++){
+        field->dist[i] = FLOW_UNREACHABLE;
+        field->dir[i] = FLOW_NONE;
+    }
+    free(field->goals);
+    field->goals = malloc((n ? n : 1)*sizeof(int));
+    if(!field->goals) _flow_alloc_failed();
+    _flow_reserve((void**)&field->seeds, &field->seed_max, n,
+                  sizeof(FlowSeed));
+    for(i=0;i<n;i++){
+        if(!_flow_open(field, goals_x[i], goals_y[i])) continue;
+        cell = goals_y[i]*field->width+goals_x[i];
+        field->goals[num] = cell;
+        field->dist[cell] = 0;
+        field->seeds[num].dist = 0;
+        field->seeds[num].cell = cell;
+        num++;
+    }
+    field->goal_num = num;
+    _flow_propagate(field, num);
+}
+
+/* Find the distance of the cell at x, y from its neighbors. */
+void _flow_from_neighbors(FlowField *field, int x, int y) {
+    int d;
+    int cell = y*field->width+x;
+    int next;
+    int moves = _flow_moves(field, x, y);
+    unsigned int dist;
+    for(d=0;d<8;d++){
+        if(!(moves>>d&1)) continue;
+        next = cell+_flow_dy[d]*field->width+_flow_dx[d];
+        if(field->dist[next] == FLOW_UNREACHABLE) continue;
+        dist = field->dist[next]+(d&1 ? FLOW_DIAGONAL : FLOW_STRAIGHT);
+        if(dist < field->dist[cell]){
+            field->dist[cell] = dist;
+            field->dir[cell] = d;
+        }
+    }
+}
+
+/* Check if the cell at x, y moves to the cell at tx, ty, or with along, if it
+ * moves diagonally next to it. */
+char _flow_depends_on(FlowField *field, int x, int y, int tx, int ty,
+                      char along) {
+    int d = field->dir[y*field->width+x];
+    if(d == FLOW_NONE) return 0;
+    if(x+_flow_dx[d] == tx && y+_flow_dy[d] == ty) return 1;
+    return along && (d&1) && ((x+_flow_dx[d] == tx && y == ty) ||
+                              (x == tx && y+_flow_dy[d] == ty));
+}
+
+void flowfield_update_tile(FlowField *field, int x, int y) {
+    int i;
+    int d;
+    int n = 0;
+    int seed_num = 0;
+    int cell = y*field->width+x;
+    int nx, ny;
+    int next;
+    if(x < 0 || x >= field->width || y < 0 || y >= field->height) return;
+    if(!_flow_open(field, x, y)){
+        /* The cells whose path went through the cell have to find another
+         * one, starting with the cell itself. */
+        _flow_reserve((void**)&field->stack, &field->stack_max, 1,
+                      sizeof(int));
+        field->stack[n++] = cell;
+        field->dist[cell] = FLOW_UNREACHABLE;
+        field->dir[cell] = FLOW_NONE;
+        for(i=0;i<n;i++){
+            nx = field->stack[i]%field->width;
+            ny = field->stack[i]/field->width;
+            for(d=0;d<8;d++){
+                if(nx+_flow_dx[d] < 0 || nx+_flow_dx[d] >= field->width ||
+                   ny+_flow_dy[d] < 0 || ny+_flow_dy[d] >= field->height){
+                    continue;
+                }
+                next = field->stack[i]+_flow_dy[d]*field->width+_flow_dx[d];
+                if(field->dist[next] == FLOW_UNREACHABLE) continue;
+                /* The cells moving diagonally along the wall depend on it
+                 * too. */
+                if(!_flow_depends_on(field, nx+_flow_dx[d], ny+_flow_dy[d],
+                                     nx, ny, !i)) continue;
+                _flow_reserve((void**)&field->stack, &field->stack_max, n+1,
+                              sizeof(int));
+                field->stack[n++] = next;
+                field->dist[next] = FLOW_UNREACHABLE;
+                field->dir[next] = FLOW_NONE;
+            }
+        }
+        /* Restart from the cells around them. */
+        _flow_reserve((void**)&field->seeds, &field->seed_max, n,
+                      sizeof(FlowSeed));
+        for(i=1;i<n;i++){
+            nx = field->stack[i]%field->width;
+            ny = field->stack[i]/field->width;
+            _flow_from_neighbors(field, nx, ny);
+            if(field->dist[field->stack[i]] == FLOW_UNREACHABLE) continue;
+            field->seeds[seed_num].dist = field->dist[field->stack[i]];
+            field->seeds[seed_num].cell = field->stack[i];
+            seed_num++;
+        }
+    }else{
+        /* The cell and the diagonal moves next to it are now possible,
+         * propagate from the cell and its neighbors. */
+        _flow_reserve((void**)&field->seeds, &field->seed_max, 9,
+                      sizeof(FlowSeed));
+        for(i=0;i<field->goal_num && field->goals[i] != cell;i++);
+        if(i < field->goal_num){
+            field->dist[cell] = 0;
+            field->dir[cell] = FLOW_NONE;
+        }else{
+            _flow_from_neighbors(field, x, y);
+        }
+        if(field->dist[cell] != FLOW_UNREACHABLE){
+            field->seeds[seed_num].dist = field->dist[cell];
+            field->seeds[seed_num].cell = cell;
+            seed_num++;
+        }
+        for(d=0;d<8;d++){
+            if(!_flow_open(field, x+_flow_dx[d], y+_flow_dy[d])) continue;
+            next = cell+_flow_dy[d]*field->width+_flow_dx[d];
+            if(field->dist[next] == FLOW_UNREACHABLE) continue;
+            field->seeds[seed_num].dist = field->dist[next];
+            field->seeds[seed_num].cell = next;
+            seed_num++;
+        }
+    }
+    _flow_propagate(field, seed_num);
+}
+
+void flowfield_direction(FlowField *field, fixed_t x, fixed_t y, fixed_t *dx,
+                         fixed_t *dy) {
+    int cx = TO_INT(x);
+    int cy = TO_INT(y);
+    int d;
+    *dx = *dy = 0;
+    if(cx < 0 || cx >= field->width || cy < 0 || cy >= field->height) return;
+    d = FLOWFIELD_DIR(field, cx, cy);
+    if(d == FLOW_NONE) return;
+    if(d&1){
+        *dx = _flow_dx[d]*TO_FIXED(0.70710678);
+        *dy = _flow_dy[d]*TO_FIXED(0.70710678);
+    }else{
+        *dx = TO_FIXED(_flow_dx[d]);
+        *dy = TO_FIXED(_flow_dy[d]);
+    }
+}
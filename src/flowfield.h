@@ -0,0 +1,114 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FLOWFIELD_H
+#define FLOWFIELD_H
+
+#include <fixed.h>
+#include <map.h>
+
+/* A flow field leading to the nearest of a set of goals over the walls of a
+ * map, shared by all the agents going to these goals: each agent only looks
+ * up the direction of its cell. The distance to the goals is computed with
+ * Dijkstra's algorithm, moving to the 8 neighbors of a cell (diagonally only
+ * if the two cells on the sides are open). */
+
+/* The cost of moving to an orthogonal and to a diagonal neighbor. */
+#define FLOW_STRAIGHT 10
+#define FLOW_DIAGONAL 14
+
+/* The distance of the cells from which no goal can be reached. */
+#define FLOW_UNREACHABLE 0xFFFFFFFFU
+
+/* The directions to take, north being toward y = 0. The goals, the walls and
+ * the cells from which no goal can be reached have FLOW_NONE. */
+enum {
+    FLOW_E,
+    FLOW_SE,
+    FLOW_S,
+    FLOW_SW,
+    FLOW_W,
+    FLOW_NW,
+    FLOW_N,
+    FLOW_NE,
+    FLOW_NONE
+};
+
+/* A cell waiting to be processed with the distance it had when added. */
+typedef struct {
+    unsigned int dist;
+    int cell;
+} FlowSeed;
+
+typedef struct {
+    Map *map;
+    int width, height;
+    unsigned int *dist; /* The distance to the nearest goal of each cell. */
+    unsigned char *dir; /* The direction to take in each cell. */
+    int *goals;
+    int goal_num;
+    /* The priority queue, FLOW_DIAGONAL+1 buckets of cells used circularly.
+     * They are kept between two updates. */
+    int *buckets[FLOW_DIAGONAL+1];
+    int bucket_len[FLOW_DIAGONAL+1];
+    int bucket_max[FLOW_DIAGONAL+1];
+    /* The cells whose distance has to be recomputed. */
+    int *stack;
+    int stack_max;
+    /* The cells from which the distances are propagated, by distance. */
+    FlowSeed *seeds;
+    int seed_max;
+} FlowField;
+
+void flowfield_init(FlowField *field, Map *map);
+
+void flowfield_free(FlowField *field);
+
+/* Compute the field leading to the n cells at goals_x[i], goals_y[i]. */
+void flowfield_build(FlowField *field, const int *goals_x, const int *goals_y,
+                     int n);
+
+/* Update the field after the tile at x, y changed, only recomputing the cells
+ * whose distance changed. */
+void flowfield_update_tile(FlowField *field, int x, int y);
+
+/* The direction to take at x, y, one of FLOW_*. */
+#define FLOWFIELD_DIR(field, x, y) ((field)->dir[(y)*(field)->width+(x)])
+
+/* Get the unit vector of the direction to take at x, y (in cells) in *dx,
+ * *dy, 0, 0 if there is none. */
+void flowfield_direction(FlowField *field, fixed_t x, fixed_t y, fixed_t *dx,
+                         fixed_t *dy);
+
+#endif
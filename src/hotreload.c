@@ -0,0 +1,281 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* pthreads, poll and pipe are POSIX. */
+#define _POSIX_C_SOURCE 200809L
+
+#include <hotreload.h>
+
+#if HOTRELOAD
+
+#include <texpack.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <poll.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/inotify.h>
+
+/* Time to wait for the other changes after a file changed, in ms. */
+#define SETTLE_MS 50
+
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    int inotify;
+    int quit[2]; /* A pipe written to stop the thread. */
+    /* Watched files */
+    char map_dir[PATH_MAX];
+    const char *map_name;
+    int map_wd;
+    char pack_dir[PATH_MAX];
+    const char *pack_name;
+    int pack_wd;
+    const char *map_path;
+    const char *pack_path;
+    MapTexture *textures;
+    int texture_num;
+    /* The last pack opened by the thread. Its contents belong to the main
+     * thread once they were installed, which only closes them after a newer
+     * pack was installed. */
+    TexPack pack;
+    char has_pack;
+    /* Loaded and waiting for hotreload_update, protected by lock. */
+    int changes;
+    MapFile map_next;
+    TexPack pack_next;
+} Watcher;
+
+/* Watch the directory containing path and return the name of the file. */
+const char *_hotreload_watch(Watcher *watcher, const char *path, char *dir,
+                             int *wd) {
+    const char *name = strrchr(path, '/');
+    if(name){
+        if((size_t)(name-path) >= PATH_MAX) return NULL;
+        memcpy(dir, path, name-path);
+        dir[name-path] = '\0';
+        if(!dir[0]) strcpy(dir, "/");
+        name++;
+    }else{
+        strcpy(dir, ".");
+        name = path;
+    }
+    *wd = inotify_add_watch(watcher->inotify, dir,
+                            IN_CLOSE_WRITE | IN_MOVED_TO);
+    return *wd < 0 ? NULL : name;
+}
+
+/* Load the files again, and hand them over to the main thread. */
+void _hotreload_load(Watcher *watcher, int changes) {
+    TexPack pack;
+    MapFile map;
+    TexPack *map_pack = watcher->has_pack ? &watcher->pack : NULL;
+    if(changes&HOTRELOAD_TEXTURES){
+        if(texpack_open(&pack, watcher->pack_path)) return;
+        map_pack = &pack;
+    }
+    /* The textures used by the map are decoded here. */
+    if(mapfile_load(&map, watcher->map_path, watcher->textures,
+                    watcher->texture_num, map_pack)){
+        if(changes&HOTRELOAD_TEXTURES) texpack_close(&pack);
+        return;
+    }
+    pthread_mutex_lock(&watcher->lock);
+    if(watcher->changes) mapfile_free(&watcher->map_next);
+    watcher->map_next = map;
+    if(changes&HOTRELOAD_TEXTURES){
+        /* Only the map that was just freed used the pack that was waiting. */
+        if(watcher->changes&HOTRELOAD_TEXTURES){
+            texpack_close(&watcher->pack_next);
+        }
+        watcher->pack_next = pack;
+        watcher->pack = pack;
+    }
+    watcher->changes |= changes;
+    pthread_mutex_unlock(&watcher->lock);
+}
+
+void *_hotreload_thread(void *arg) {
+    Watcher *watcher = arg;
+    struct pollfd fds[2];
+    char buf[sizeof(struct inotify_event)+NAME_MAX+1];
+    struct inotify_event *event;
+    ssize_t size;
+    ssize_t i;
+    int changes = 0;
+    fds[0].fd = watcher->inotify;
+    fds[0].events = POLLIN;
+    fds[1].fd = watcher->quit[0];
+    fds[1].events = POLLIN;
+    for(;;){
+        /* Wait until the files stopped changing before loading them. */
+        if(poll(fds, 2, changes ? SETTLE_MS : -1) < 0) continue;
+        if(fds[1].revents) break;
+        if(!fds[0].revents){
+            _hotreload_load(watcher, changes);
+            changes = 0;
+            continue;
+        }
+        size = read(watcher->inotify, buf, sizeof(buf));
+        for(i=0;i<size;i+=sizeof(struct inotify_event)+event->len){
+            event = (struct inotify_event*)(buf+i);
+            if(!event->len) continue;
+            if(event->wd == watcher->map_wd &&
+               !strcmp(event->name, watcher->map_name)){
+                changes |= HOTRELOAD_MAP;
+            }
+            if(watcher->pack_name && event->wd == watcher->pack_wd &&
+               !strcmp(event->name, watcher->pack_name)){
+                changes |= HOTRELOAD_TEXTURES;
+            }
+        }
+    }
+    return NULL;
+}
+
+int hotreload_start(HotReload *reload, MapFile *file, const char *map_path,
+                    struct TexPack *pack, const char *pack_path,
+                    MapTexture *textures, int texture_num) {
+    Watcher *watcher = malloc(sizeof(Watcher));
+    reload->file = file;
+    reload->pack = pack;
+    reload->watcher = watcher;
+    if(!watcher){
+        fputs("[hotreload] Failed to allocate the watcher!\n", stderr);
+        return -1;
+    }
+    memset(watcher, 0, sizeof(Watcher));
+    watcher->map_path = map_path;
+    watcher->pack_path = pack_path;
+    watcher->textures = textures;
+    watcher->texture_num = texture_num;
+    if(pack){
+        watcher->pack = *pack;
+        watcher->has_pack = 1;
+    }
+    watcher->inotify = inotify_init();
+    if(watcher->inotify < 0){
+        fputs("[hotreload] Failed to initialize inotify!\n", stderr);
+        free(watcher);
+        reload->watcher = NULL;
+        return -1;
+    }
+    watcher->map_name = _hotreload_watch(watcher, map_path, watcher->map_dir,
+                                         &watcher->map_wd);
+    if(pack_path){
+        watcher->pack_name = _hotreload_watch(watcher, pack_path,
+                                              watcher->pack_dir,
+                                              &watcher->pack_wd);
+    }
+    if(!watcher->map_name || (pack_path && !watcher->pack_name) ||
+       pipe(watcher->quit)){
+        fputs("[hotreload] Failed to watch the files!\n", stderr);
+        close(watcher->inotify);
+        free(watcher);
+        reload->watcher = NULL;
+        return -1;
+    }
+    pthread_mutex_init(&watcher->lock, NULL);
+    if(pthread_create(&watcher->thread, NULL, _hotreload_thread, watcher)){
+        fputs("[hotreload] Failed to start the thread!\n", stderr);
+        pthread_mutex_destroy(&watcher->lock);
+        close(watcher->quit[0]);
+        close(watcher->quit[1]);
+        close(watcher->inotify);
+        free(watcher);
+        reload->watcher = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+int hotreload_update(HotReload *reload) {
+    int changes;
+    MapFile map;
+    TexPack pack;
+    Map *old = &reload->file->map;
+    Watcher *watcher = reload->watcher;
+    pthread_mutex_lock(&watcher->lock);
+    changes = watcher->changes;
+    map = watcher->map_next;
+    pack = watcher->pack_next;
+    watcher->changes = 0;
+    pthread_mutex_unlock(&watcher->lock);
+    if(!changes) return 0;
+    /* Keep the caches built from the layers if they didn't change. */
+    map.map.revision = old->revision;
+    if(!old->data || !map.map.data || old->width != map.map.width ||
+       old->height != map.map.height ||
+       memcmp(old->data, map.map.data, old->width*old->height) ||
+       !old->floor != !map.map.floor || !old->ceiling != !map.map.ceiling ||
+       (old->floor && memcmp(old->floor, map.map.floor,
+                             old->width*old->height)) ||
+       (old->ceiling && memcmp(old->ceiling, map.map.ceiling,
+                               old->width*old->height))){
+        map.map.revision++;
+    }
+    mapfile_free(reload->file);
+    *reload->file = map;
+    if(changes&HOTRELOAD_TEXTURES){
+        texpack_close(reload->pack);
+        *reload->pack = pack;
+    }
+    return changes;
+}
+
+void hotreload_stop(HotReload *reload) {
+    Watcher *watcher = reload->watcher;
+    if(!watcher) return;
+    if(write(watcher->quit[1], "", 1) < 0){
+        fputs("[hotreload] Failed to stop the thread!\n", stderr);
+    }
+    pthread_join(watcher->thread, NULL);
+    if(watcher->changes){
+        mapfile_free(&watcher->map_next);
+        if(watcher->changes&HOTRELOAD_TEXTURES){
+            texpack_close(&watcher->pack_next);
+        }
+    }
+    pthread_mutex_destroy(&watcher->lock);
+    close(watcher->quit[0]);
+    close(watcher->quit[1]);
+    close(watcher->inotify);
+    free(watcher);
+    reload->watcher = NULL;
+}
+
+#endif
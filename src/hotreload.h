@@ -0,0 +1,77 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef HOTRELOAD_H
+#define HOTRELOAD_H
+
+#include <config.h>
+#include <mapfile.h>
+
+/* Reload a map file and its texture pack when they change on disk, so that
+ * they can be edited while the game runs. A thread watches their directories
+ * with inotify, loads the files again and keeps them until hotreload_update
+ * installs them between two frames. When the pack changes, the map is loaded
+ * again with it, so the thread always hands over a map and the pack it
+ * uses. */
+
+enum {
+    HOTRELOAD_MAP = 1,
+    HOTRELOAD_TEXTURES = 2
+};
+
+typedef struct {
+    MapFile *file;
+    struct TexPack *pack;
+    void *watcher;
+} HotReload;
+
+/* Watch the map file at map_path, loaded in file, and the texture pack at
+ * pack_path, opened in pack (both NULL if the map doesn't use a pack).
+ * textures and pack are passed to mapfile_load, and textures must stay valid
+ * until hotreload_stop is called. Returns 0 on success, prints an error and
+ * returns -1 on failure. */
+int hotreload_start(HotReload *reload, MapFile *file, const char *map_path,
+                    struct TexPack *pack, const char *pack_path,
+                    MapTexture *textures, int texture_num);
+
+/* Install the files that were loaded again, replacing the contents of file
+ * and pack. The revision of the map only changes if its layers changed, so
+ * that the caches built from the map are kept when only the textures changed.
+ * Returns a combination of HOTRELOAD_MAP and HOTRELOAD_TEXTURES, the map must
+ * then be passed to raycaster_set_map. */
+int hotreload_update(HotReload *reload);
+
+void hotreload_stop(HotReload *reload);
+
+#endif
@@ -0,0 +1,261 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* pthreads, sched_yield, clock_gettime and sysconf are POSIX. */
+#define _POSIX_C_SOURCE 200809L
+
+#include <jobs.h>
+
+#if JOBS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+    JobFunc func;
+    void *data;
+    JobGroup *group;
+} Job;
+
+/* The jobs of a worker, from top (the oldest) to bottom. */
+typedef struct {
+    Job jobs[JOBS_DEQUE];
+    unsigned int top, bottom;
+    pthread_mutex_t lock;
+} Deque;
+
+typedef struct {
+    JobSystem *jobs;
+    Deque deques[JOBS_WORKERS];
+    pthread_t threads[JOBS_WORKERS];
+    int thread_num;
+    /* The number of jobs in all the deques, and the number of workers
+     * waiting for one. */
+    int queued;
+    int sleeping;
+    char quit;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+} Pool;
+
+typedef struct {
+    Pool *pool;
+    int worker;
+} WorkerArg;
+
+unsigned long _jobs_us(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (unsigned long)t.tv_sec*1000000UL+t.tv_nsec/1000;
+}
+
+/* Take the newest job of the worker. */
+char _jobs_pop(Pool *pool, int worker, Job *job) {
+    Deque *deque = pool->deques+worker;
+    char found = 0;
+    pthread_mutex_lock(&deque->lock);
+    if(deque->bottom != deque->top){
+        *job = deque->jobs[--deque->bottom%JOBS_DEQUE];
+        found = 1;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+/* Take the oldest job of another worker. */
+char _jobs_steal(Pool *pool, int worker, Job *job) {
+    Deque *deque;
+    int i;
+    char found = 0;
+    for(i=1;i<pool->jobs->worker_num && !found;i++){
+        deque = pool->deques+(worker+i)%pool->jobs->worker_num;
+        pthread_mutex_lock(&deque->lock);
+        if(deque->bottom != deque->top){
+            *job = deque->jobs[deque->top++%JOBS_DEQUE];
+            found = 1;
+        }
+        pthread_mutex_unlock(&deque->lock);
+    }
+    return found;
+}
+
+void _jobs_run(JobSystem *jobs, int worker, Job *job) {
+    unsigned long start = _jobs_us();
+    job->func(job->data, worker);
+    jobs->busy_us[worker] += _jobs_us()-start;
+    jobs->jobs[worker]++;
+    __atomic_sub_fetch(&job->group->pending, 1, __ATOMIC_RELEASE);
+}
+
+/* Run a job of the worker or a stolen one. Returns 0 if there was none. */
+char _jobs_run_one(Pool *pool, int worker) {
+    Job job;
+    if(!_jobs_pop(pool, worker, &job)){
+        if(!_jobs_steal(pool, worker, &job)) return 0;
+        pool->jobs->steals[worker]++;
+    }
+    __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+    _jobs_run(pool->jobs, worker, &job);
+    return 1;
+}
+
+void *_jobs_worker(void *arg) {
+    Pool *pool = ((WorkerArg*)arg)->pool;
+    int worker = ((WorkerArg*)arg)->worker;
+    free(arg);
+    for(;;){
+        if(_jobs_run_one(pool, worker)) continue;
+        pthread_mutex_lock(&pool->lock);
+        __atomic_add_fetch(&pool->sleeping, 1, __ATOMIC_SEQ_CST);
+        while(!pool->quit &&
+              !__atomic_load_n(&pool->queued, __ATOMIC_SEQ_CST)){
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        __atomic_sub_fetch(&pool->sleeping, 1, __ATOMIC_SEQ_CST);
+        if(pool->quit){
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+int jobs_init(JobSystem *jobs, int worker_num) {
+    Pool *pool;
+    WorkerArg *arg;
+    int i;
+    if(worker_num < 1) worker_num = sysconf(_SC_NPROCESSORS_ONLN);
+    if(worker_num < 1) worker_num = 1;
+    if(worker_num > JOBS_WORKERS) worker_num = JOBS_WORKERS;
+    pool = malloc(sizeof(Pool));
+    if(!pool){
+        fputs("[jobs] Failed to allocate the workers!\n", stderr);
+        exit(-1);
+    }
+    jobs->worker_num = worker_num;
+    jobs->pool = pool;
+    pool->jobs = jobs;
+    pool->thread_num = 0;
+    pool->queued = 0;
+    pool->sleeping = 0;
+    pool->quit = 0;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    for(i=0;i<worker_num;i++){
+        pool->deques[i].top = pool->deques[i].bottom = 0;
+        pthread_mutex_init(&pool->deques[i].lock, NULL);
+        jobs->busy_us[i] = 0;
+        jobs->jobs[i] = 0;
+        jobs->steals[i] = 0;
+    }
+    for(i=1;i<worker_num;i++){
+        arg = malloc(sizeof(WorkerArg));
+        if(!arg){
+            fputs("[jobs] Failed to allocate the workers!\n", stderr);
+            exit(-1);
+        }
+        arg->pool = pool;
+        arg->worker = i;
+        if(pthread_create(pool->threads+pool->thread_num, NULL, _jobs_worker,
+                          arg)){
+            fputs("[jobs] Failed to start the worker threads!\n", stderr);
+            free(arg);
+            jobs_free(jobs);
+            return -1;
+        }
+        pool->thread_num++;
+    }
+    return 0;
+}
+
+void jobs_free(JobSystem *jobs) {
+    Pool *pool = jobs->pool;
+    int i;
+    if(!pool) return;
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    for(i=0;i<pool->thread_num;i++) pthread_join(pool->threads[i], NULL);
+    for(i=0;i<jobs->worker_num;i++){
+        pthread_mutex_destroy(&pool->deques[i].lock);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    free(pool);
+    jobs->pool = NULL;
+    jobs->worker_num = 0;
+}
+
+void jobs_group_init(JobGroup *group) {
+    group->pending = 0;
+}
+
+void jobs_fork(JobSystem *jobs, int worker, JobGroup *group, JobFunc func,
+               void *data) {
+    Pool *pool = jobs->pool;
+    Deque *deque = pool->deques+worker;
+    Job job;
+    job.func = func;
+    job.data = data;
+    job.group = group;
+    __atomic_add_fetch(&group->pending, 1, __ATOMIC_RELAXED);
+    pthread_mutex_lock(&deque->lock);
+    if(deque->bottom-deque->top >= JOBS_DEQUE){
+        pthread_mutex_unlock(&deque->lock);
+        _jobs_run(jobs, worker, &job);
+        return;
+    }
+    deque->jobs[deque->bottom++%JOBS_DEQUE] = job;
+    /* Counted before it can be taken, so that queued is never negative. */
+    __atomic_add_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&deque->lock);
+    if(__atomic_load_n(&pool->sleeping, __ATOMIC_SEQ_CST)){
+        pthread_mutex_lock(&pool->lock);
+        pthread_cond_signal(&pool->wake);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+void jobs_join(JobSystem *jobs, int worker, JobGroup *group) {
+    while(__atomic_load_n(&group->pending, __ATOMIC_ACQUIRE)){
+        if(!_jobs_run_one(jobs->pool, worker)) sched_yield();
+    }
+}
+
+#endif
@@ -0,0 +1,92 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <config.h>
+
+#if JOBS
+
+/* A work-stealing job scheduler. Each worker has a deque of jobs: it pushes
+ * and takes its own jobs at the bottom, and when it has none left it steals
+ * the oldest job of another worker, which is usually the biggest one. A job
+ * can fork other jobs and join them. The thread that calls jobs_init is the
+ * worker 0, and the functions that take a worker must be called with the
+ * worker running the caller. */
+
+/* Maximum number of workers. */
+#define JOBS_WORKERS 64
+/* Maximum number of jobs waiting in the deque of a worker. When it is full,
+ * jobs_fork runs the job right away. */
+#define JOBS_DEQUE 256
+
+/* The job function, run by worker. */
+typedef void (*JobFunc)(void *data, int worker);
+
+/* Jobs that can be waited for together. */
+typedef struct {
+    int pending;
+} JobGroup;
+
+typedef struct {
+    int worker_num;
+    /* For each worker, the time spent running jobs in microseconds, the
+     * number of jobs run and how many of them were stolen. They are only
+     * up to date for the jobs that were joined. */
+    unsigned long busy_us[JOBS_WORKERS];
+    unsigned long jobs[JOBS_WORKERS];
+    unsigned long steals[JOBS_WORKERS];
+    void *pool;
+} JobSystem;
+
+/* Start worker_num workers, including the calling thread (0 for one per
+ * processor). Returns 0 on success, prints an error and returns -1 on
+ * failure. */
+int jobs_init(JobSystem *jobs, int worker_num);
+
+void jobs_free(JobSystem *jobs);
+
+void jobs_group_init(JobGroup *group);
+
+/* Add a job of group that calls func with data. */
+void jobs_fork(JobSystem *jobs, int worker, JobGroup *group, JobFunc func,
+               void *data);
+
+/* Run jobs until all the jobs of group are done. */
+void jobs_join(JobSystem *jobs, int worker, JobGroup *group);
+
+#endif
+
+#endif
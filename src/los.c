@@ -0,0 +1,170 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <los.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+char los_visible(Map *map, fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2) {
+    int cx = TO_INT(x1);
+    int cy = TO_INT(y1);
+    int ex = TO_INT(x2);
+    int ey = TO_INT(y2);
+    int sx = x2 > x1 ? 1 : -1;
+    int sy = y2 > y1 ? 1 : -1;
+    int steps = ABS(ex-cx)+ABS(ey-cy);
+    fixed_t dx = ABS(x2-x1);
+    fixed_t dy = ABS(y2-y1);
+    /* The segment crosses the next vertical edge at t = tx/(dx*dy) and the
+     * next horizontal edge at t = ty/(dx*dy), both scaled by 1<<PRECISION, so
+     * they can be compared without dividing. */
+    fixed_t tx = FIXED_MAX;
+    fixed_t ty = FIXED_MAX;
+    if(dx) tx = (sx > 0 ? FLOOR(x1)+TO_FIXED(1)-x1 : x1-FLOOR(x1))*dy;
+    if(dy) ty = (sy > 0 ? FLOOR(y1)+TO_FIXED(1)-y1 : y1-FLOOR(y1))*dx;
+    while(steps > 0 && (cx != ex || cy != ey)){
+        if(tx < ty){
+            cx += sx;
+            tx += dy<<PRECISION;
+            steps--;
+        }else if(ty < tx){
+            cy += sy;
+            ty += dx<<PRECISION;
+            steps--;
+        }else{
+            /* Through a corner. */
+            if(MAP_TILE(map, cx+sx, cy) && MAP_TILE(map, cx, cy+sy)){
+                return 0;
+            }
+            cx += sx;
+            cy += sy;
+            tx += dy<<PRECISION;
+            ty += dx<<PRECISION;
+            steps -= 2;
+        }
+        if(cx == ex && cy == ey) break;
+        if(MAP_TILE(map, cx, cy)) return 0;
+    }
+    return 1;
+}
+
+void los_cache_init(LosCache *cache, int size) {
+    int i;
+    cache->size = 1;
+    while(cache->size < size) cache->size *= 2;
+    cache->entries = malloc(cache->size*sizeof(LosEntry));
+    if(!cache->entries){
+        fputs("[los] Failed to allocate the cache!\n", stderr);
+        exit(-1);
+    }
+    for(i=0;i<cache->size;i++) cache->entries[i].generation = 0;
+    cache->generation = 1;
+    cache->map = NULL;
+    cache->revision = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+}
+
+void los_cache_free(LosCache *cache) {
+    free(cache->entries);
+    cache->entries = NULL;
+    cache->size = 0;
+}
+
+/* Drop all the entries if the map changed. */
+void _los_check_map(LosCache *cache, Map *map) {
+    int i;
+    if(cache->map == map && cache->revision == map->revision) return;
+    cache->map = map;
+    cache->revision = map->revision;
+    cache->generation++;
+    if(!cache->generation){
+        for(i=0;i<cache->size;i++) cache->entries[i].generation = 0;
+        cache->generation = 1;
+    }
+}
+
+/* The visibility between x1, y1 and x2, y2, through the cache. */
+char _los_cached(LosCache *cache, Map *map, fixed_t x1, fixed_t y1,
+                 fixed_t x2, fixed_t y2) {
+    fixed_t tmp;
+    unsigned long h;
+    LosEntry *entry;
+    /* The walk is symmetric, store each pair of points once. */
+    if(y1 > y2 || (y1 == y2 && x1 > x2)){
+        tmp = x1;
+        x1 = x2;
+        x2 = tmp;
+        tmp = y1;
+        y1 = y2;
+        y2 = tmp;
+    }
+    h = (unsigned long)x1*73856093UL^(unsigned long)y1*19349663UL^
+        (unsigned long)x2*83492791UL^(unsigned long)y2*2654435761UL;
+    /* The low bits of the points are often 0, bring the high bits down. */
+    h ^= h>>16;
+    entry = cache->entries+(h&(cache->size-1));
+    if(entry->generation == cache->generation && entry->x1 == x1 &&
+       entry->y1 == y1 && entry->x2 == x2 && entry->y2 == y2){
+        cache->hits++;
+        return entry->visible;
+    }
+    cache->misses++;
+    entry->x1 = x1;
+    entry->y1 = y1;
+    entry->x2 = x2;
+    entry->y2 = y2;
+    entry->generation = cache->generation;
+    entry->visible = los_visible(map, x1, y1, x2, y2);
+    return entry->visible;
+}
+
+void los_batch(Map *map, const LosQuery *queries, int n,
+               unsigned char *visible, LosCache *cache) {
+    int i;
+    char v;
+    const LosQuery *q;
+    if(cache) _los_check_map(cache, map);
+    for(i=0;i<n;i++){
+        q = queries+i;
+        if(cache){
+            v = _los_cached(cache, map, q->x1, q->y1, q->x2, q->y2);
+        }else{
+            v = los_visible(map, q->x1, q->y1, q->x2, q->y2);
+        }
+        if(v) visible[i/8] |= 1<<(i%8);
+        else visible[i/8] &= ~(1<<(i%8));
+    }
+}
@@ -0,0 +1,92 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LOS_H
+#define LOS_H
+
+#include <fixed.h>
+#include <map.h>
+
+/* Line of sight queries between many pairs of points, e.g. for the AI. The
+ * segment between the two points is walked cell by cell with integer
+ * arithmetic only, and the walk stops at the first wall. The cells of the
+ * two points themselves never block. When the segment goes exactly through
+ * the corner of a cell, it is only blocked if both cells next to the corner
+ * are walls.
+ * With FAST, the products used by the walk overflow on maps bigger than 362
+ * by 362 cells. */
+
+typedef struct {
+    fixed_t x1, y1;
+    fixed_t x2, y2;
+} LosQuery;
+
+typedef struct {
+    fixed_t x1, y1;
+    fixed_t x2, y2;
+    unsigned int generation; /* 0 if the entry is empty. */
+    char visible;
+} LosEntry;
+
+/* A cache of the results of the queries, keyed by the two points, so that it
+ * gives the same answers as los_visible. It pays off when the same points are
+ * queried again, e.g. agents that don't move between two batches. All the
+ * entries are dropped when the map or its revision changes. */
+typedef struct {
+    LosEntry *entries;
+    int size; /* A power of two. */
+    unsigned int generation;
+    Map *map;
+    unsigned int revision;
+    /* Stats */
+    unsigned long hits;
+    unsigned long misses;
+} LosCache;
+
+/* Initialize cache with at least size entries. */
+void los_cache_init(LosCache *cache, int size);
+
+void los_cache_free(LosCache *cache);
+
+/* Returns 1 if x2, y2 can be seen from x1, y1 in map, 0 otherwise. Both
+ * points have to be inside of the map. */
+char los_visible(Map *map, fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2);
+
+/* Answer the n queries, setting the bit i%8 of visible[i/8] if the query i is
+ * visible and clearing it otherwise. The answers go through cache if it is
+ * not NULL. */
+void los_batch(Map *map, const LosQuery *queries, int n,
+               unsigned char *visible, LosCache *cache);
+
+#endif
@@ -36,19 +36,40 @@
 #include <fixed.h>
 #include <raycaster.h>
 #include <map.h>
+#include <entity.h>
 
 #include <stdio.h>
 #include <stdlib.h>
-
-#define MAP_WIDTH  32
-#define MAP_HEIGHT 32
+#include <string.h>
 
 #define SPRITE_NUM 3
 
+/* Use a map full of sprites to benchmark the sprite pass. */
+#define SPRITE_BENCH 0
+
 #include <testmap.h>
+#include <spritemap.h>
 
 #include <sprite.h>
 
+#if MAPFILE
+#include <mapfile.h>
+#include <wall.h>
+#include <wood.h>
+#endif
+
+#if TEXPACK
+#include <texpack.h>
+#endif
+
+#if HOTRELOAD
+#include <hotreload.h>
+#endif
+
+#if JOBS
+#include <jobs.h>
+#endif
+
 #define SCREEN_WIDTH  640
 #define SCREEN_HEIGHT 480
 
@@ -67,11 +88,36 @@
 
 #define TEXTURE 1
 
+/* Frame time in ms to keep with the dynamic resolution (0 to disable it). */
+#define TARGET_MS 0
+/* Low detail mode, see DETAIL_HALF_X and DETAIL_HALF_Y. */
+#define DETAIL 0
+
+/* Only cast the rays needed to find the edges of the walls. */
+#define ADAPTIVE 1
+
+/* Only redraw what changed when the view did not move. Needs a renderer that
+ * keeps the screen between frames (not the case with gint's double
+ * buffering). */
+#define INCREMENTAL 0
+
+/* Reuse the rays of the last frames when only turning. */
+#define REUSE_RAYS 1
+
+/* Size of a cell of the minimap in pixels (0 to hide it). */
+#define MINIMAP 0
+
 #define COLLISIONS 1
+/* The radius of the player in cells, when colliding with the walls. */
+#define PLAYER_RADIUS 0.2
 
 Raycaster raycaster;
 Renderer *renderer = &raycaster.renderer;
+#if SPRITE_BENCH
+Map *map = &spritemap;
+#else
 Map *map = &testmap;
+#endif
 
 char lock = 0;
 
@@ -79,76 +125,57 @@ char map_view = 1;
 
 char show_fps = 1;
 
+#if HOTRELOAD
+HotReload reload;
+char reloading = 0;
+#endif
+
+#if JOBS
+JobSystem jobs;
+#endif
+
+#if PERFCOUNT
+PerfCounters counters;
+#endif
+
+#if CHUNKMAP
+char profile_text[PROFILE_TEXT_MAX+4+CHUNKMAP_TEXT_MAX];
+#else
+char profile_text[PROFILE_TEXT_MAX];
+#endif
+
 void loop(int fps) {
-    fixed_t oldx;
-    fixed_t oldy;
-    int tx, ty;
+    fixed_t step;
+    fixed_t dx, dy;
+#if HOTRELOAD
+    /* Install the files that were edited, between two frames. */
+    if(reloading && hotreload_update(&reload)){
+        raycaster_set_map(&raycaster, map);
+    }
+#endif
     if(render_keydown(renderer, KEY_LEFT)){
         raycaster.r -= TO_FIXED(ROTSPEED)/fps;
     }
     if(render_keydown(renderer, KEY_RIGHT)){
         raycaster.r += TO_FIXED(ROTSPEED)/fps;
     }
+    step = DIV(TO_FIXED(SPEED), TO_FIXED(fps));
+    dx = dy = 0;
     if(render_keydown(renderer, KEY_UP)){
-        oldx = raycaster.x;
-        oldy = raycaster.y;
-        raycaster.x += MUL(DCOS(raycaster.r), DIV(TO_FIXED(SPEED),
-                           TO_FIXED(fps)));
-#if COLLISIONS
-        tx = TO_INT(raycaster.x);
-        ty = TO_INT(raycaster.y);
-        if(tx >= 0 && tx < MAP_WIDTH && ty >= 0 && ty < MAP_HEIGHT){
-            if(map_get_tile(map, tx, ty) > 0){
-                raycaster.x = oldx;
-            }
-        }else{
-            raycaster.x = oldx;
-        }
-#endif
-        raycaster.y += MUL(DSIN(raycaster.r), DIV(TO_FIXED(SPEED),
-                           TO_FIXED(fps)));
-#if COLLISIONS
-        tx = TO_INT(raycaster.x);
-        ty = TO_INT(raycaster.y);
-        if(tx >= 0 && tx < MAP_WIDTH && ty >= 0 && ty < MAP_HEIGHT){
-            if(map_get_tile(map, tx, ty) > 0){
-                raycaster.y = oldy;
-            }
-        }else{
-            raycaster.y = oldy;
-        }
-#endif
+        dx += MUL(DCOS(raycaster.r), step);
+        dy += MUL(DSIN(raycaster.r), step);
     }
     if(render_keydown(renderer, KEY_DOWN)){
-        oldx = raycaster.x;
-        oldy = raycaster.y;
-        raycaster.x -= MUL(DCOS(raycaster.r), DIV(TO_FIXED(SPEED),
-                           TO_FIXED(fps)));
-#if COLLISIONS
-        tx = TO_INT(raycaster.x);
-        ty = TO_INT(raycaster.y);
-        if(tx >= 0 && tx < MAP_WIDTH && ty >= 0 && ty < MAP_HEIGHT){
-            if(map_get_tile(map, tx, ty) > 0){
-                raycaster.x = oldx;
-            }
-        }else{
-            raycaster.x = oldx;
-        }
-#endif
-        raycaster.y -= MUL(DSIN(raycaster.r), DIV(TO_FIXED(SPEED),
-                           TO_FIXED(fps)));
+        dx -= MUL(DCOS(raycaster.r), step);
+        dy -= MUL(DSIN(raycaster.r), step);
+    }
 #if COLLISIONS
-        tx = TO_INT(raycaster.x);
-        ty = TO_INT(raycaster.y);
-        if(tx >= 0 && tx < MAP_WIDTH && ty >= 0 && ty < MAP_HEIGHT){
-            if(map_get_tile(map, tx, ty) > 0){
-                raycaster.y = oldy;
-            }
-        }else{
-            raycaster.y = oldy;
-        }
+    entity_move(map, &raycaster.x, &raycaster.y, TO_FIXED(PLAYER_RADIUS), dx,
+                dy);
+#else
+    raycaster.x += dx;
+    raycaster.y += dy;
 #endif
-    }
     if(!lock){
         if(render_keydown(renderer, KEY_LCTRL)){
             map_view = !map_view;
@@ -177,19 +204,114 @@ void loop(int fps) {
     }else{
         raycaster_render_world(&raycaster);
     }
-    if(show_fps) render_show_fps(renderer);
+    if(show_fps){
+        if(map_view){
+            render_show_fps(renderer);
+        }else{
+            profile_format(&raycaster.profile, profile_text);
+#if CHUNKMAP
+            if(map->chunks){
+                strcat(profile_text, "    ");
+                chunkmap_format(map->chunks,
+                                profile_text+strlen(profile_text));
+            }
+#endif
+            render_show_text(renderer, profile_text);
+        }
+    }
+    if(!map_view){
+        profile_start(&raycaster.profile, PROFILE_PRESENT,
+                      render_us(renderer));
+    }
     render_update(renderer);
+    if(!map_view){
+        profile_stop(&raycaster.profile, PROFILE_PRESENT,
+                     render_us(renderer));
+    }
 }
 
 int main(int argc, char **argv) {
     Sprite sprites[SPRITE_NUM] = {
-        {TO_FIXED(1.5), TO_FIXED(2.5), 0, &sprite, 1, 0, 0, NULL},
-        {TO_FIXED(8.5), TO_FIXED(8.5), 0, &sprite, 1, 0, 0, NULL},
-        {TO_FIXED(8.5), TO_FIXED(9.5), 0, &sprite, 1, 0, 0, NULL},
+        {TO_FIXED(1.5), TO_FIXED(2.5), &sprite, 1, NULL},
+        {TO_FIXED(8.5), TO_FIXED(8.5), &sprite, 1, NULL},
+        {TO_FIXED(8.5), TO_FIXED(9.5), &sprite, 1, NULL},
     };
     fixed_t zbuffer[SCREEN_WIDTH];
+#if PERFCOUNT
+    int i;
+#endif
+#if MAPFILE
+    MapFile file;
+    MapTexture textures[3] = {
+        {"wall", &wall},
+        {"wood", &wood},
+        {"sprite", &sprite}
+    };
+    struct TexPack *pack = NULL;
+#if TEXPACK
+    TexPack texpack;
+    /* The textures of the map can be replaced by the ones of a texture
+     * pack, given as second argument. */
+    if(argc > 2){
+        if(texpack_open(&texpack, argv[2])) return 1;
+        pack = &texpack;
+    }
+#endif
+    /* Load the map file given as argument, if any. */
+    if(argc > 1){
+        if(mapfile_load(&file, argv[1], textures, 3, pack)) return 1;
+        map = &file.map;
+    }
+#endif
     raycaster_init(&raycaster, SCREEN_WIDTH, SCREEN_HEIGHT, "Simple Raycaster",
                    map, TO_FIXED(1.5), TO_FIXED(1.5), TO_FIXED(45), zbuffer);
+    raycaster.target_ms = TARGET_MS;
+    raycaster.detail = DETAIL;
+    raycaster.adaptive = ADAPTIVE;
+    raycaster.incremental = INCREMENTAL;
+    raycaster.reuse_rays = REUSE_RAYS;
+    raycaster.minimap = MINIMAP;
+#if PERFCOUNT
+    if(perfcount_open(&counters)){
+        raycaster.profile.counters = &counters;
+    }else{
+        fputs("[main] No performance counters, only timing the stages\n",
+              stderr);
+    }
+#endif
+#if JOBS
+    /* Share the frames between all the processors. */
+    if(!jobs_init(&jobs, 0)) raycaster.jobs = &jobs;
+#endif
+#if HOTRELOAD
+    if(argc > 1){
+        reloading = !hotreload_start(&reload, &file, argv[1], pack,
+                                     argc > 2 ? argv[2] : NULL, textures, 3);
+    }
+#endif
     render_main_loop(renderer, loop);
+#if HOTRELOAD
+    if(reloading) hotreload_stop(&reload);
+#endif
+#if PERFCOUNT
+    /* Show the average events per frame of each stage. */
+    if(raycaster.profile.counters){
+        for(i=0;i<PROFILE_STAGES;i++){
+            profile_format_events(&raycaster.profile, i, 1, profile_text);
+            puts(profile_text);
+        }
+        perfcount_close(&counters);
+    }
+#endif
+#if JOBS
+    if(raycaster.jobs) jobs_free(&jobs);
+#endif
+    raycaster_free(&raycaster);
+#if MAPFILE
+    if(argc > 1) mapfile_free(&file);
+#endif
+#if TEXPACK
+    if(pack) texpack_close(pack);
+#endif
     return 0;
 }
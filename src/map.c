@@ -36,7 +36,19 @@
 
 int map_get_tile(Map *map, int x, int y) {
     if(x >= 0 && x < map->width && y >= 0 && y < map->height){
-        return map->data[y*map->width+x];
+        return MAP_TILE(map, x, y);
     }
     return -1;
-}
\ No newline at end of file
+}
+
+void map_set_tile(Map *map, int x, int y, unsigned char tile) {
+    if(x >= 0 && x < map->width && y >= 0 && y < map->height){
+#if CHUNKMAP
+        if(!map->data) chunkmap_set(map->chunks, x, y, tile);
+        else map->data[y*map->width+x] = tile;
+#else
+        map->data[y*map->width+x] = tile;
+#endif
+        map->revision++;
+    }
+}
@@ -35,16 +35,18 @@
 #ifndef MAP_H
 #define MAP_H
 
+#include <config.h>
 #include <texture.h>
 #include <fixed.h>
 
+#if CHUNKMAP
+#include <chunkmap.h>
+#endif
+
 typedef struct {
     fixed_t x, y;
-    fixed_t dist;
     Texture *texture;
     char visible;
-    int screen_x;
-    int h; /* without clipping. */
     void *extra_data;
 } Sprite;
 
@@ -55,14 +57,47 @@ typedef struct {
 
 typedef struct {
     unsigned char *data;
+    /* Floor and ceiling tiles, NULL if the map has none. */
+    unsigned char *floor;
+    unsigned char *ceiling;
     int width;
     int height;
     Tile *tileset;
     Sprite *sprites;
     int sprite_num;
     void *extra_data;
+    /* Incremented each time the map is modified. If you modify the layers
+     * directly, increment it too. */
+    unsigned int revision;
+    /* When data is NULL, the tiles are streamed from a file by chunks (see
+     * chunkmap.h). */
+    struct ChunkMap *chunks;
 } Map;
 
+/* The tile at x, y, which has to be inside of the map. */
+#if CHUNKMAP
+#define MAP_TILE(map, x, y) ((map)->data ? \
+                             (map)->data[(y)*(map)->width+(x)] : \
+                             chunkmap_get((map)->chunks, x, y))
+#else
+#define MAP_TILE(map, x, y) ((map)->data[(y)*(map)->width+(x)])
+#endif
+
+/* A row of pixels textured with a tile layer. x and y are the map coordinates
+ * of the first pixel and dx and dy the step between two pixels. */
+typedef struct {
+    unsigned char *layer;
+    Tile *tileset;
+    int map_width;
+    int map_height;
+    fixed_t x, y;
+    fixed_t dx, dy;
+    int fog;
+} Span;
+
 int map_get_tile(Map *map, int x, int y);
 
+/* Change the tile at x, y and increment the revision of the map. */
+void map_set_tile(Map *map, int x, int y, unsigned char tile);
+
 #endif
@@ -0,0 +1,183 @@
+"""
+A quick and dirty raycaster.
+mapconv.py: generate a binary map file from map data.
+by Mibi88
+
+This software is licensed under the BSD-3-Clause license:
+
+Copyright (c) 2024 Mibi88.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holder nor the names of its
+    contributors may be used to endorse or promote products derived from this
+    software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+"""
+
+from PIL import Image
+import sys
+import os
+import json
+import struct
+
+VERSION = 1
+NAME_MAX = 32
+
+DATA, FLOOR, CEILING, TEXTURES, TILESET, SPRITES = range(1, 7)
+# 7 held the blocks of cells with walls, now skipped.
+CHUNKS = 8
+
+VISIBLE = 1
+
+if len(sys.argv) < 4:
+    sys.stderr.write("USAGE: mapconv [MAP] [EXTRADATA] [OUTPUT] "
+                     "[CHUNK SIZE]\n")
+    sys.exit(1)
+
+infile = sys.argv[1]
+extradata = sys.argv[2]
+output = sys.argv[3]
+
+# Store the walls by chunks to stream them (see chunkmap.h).
+chunksize = 0
+if len(sys.argv) > 4:
+    try:
+        chunksize = int(sys.argv[4])
+    except ValueError:
+        chunksize = 0
+    if chunksize < 1 or chunksize & (chunksize-1):
+        sys.stderr.write("mapconv: The chunk size must be a power of two!\n")
+        sys.exit(1)
+
+img = Image.open(infile).convert("RGB")
+
+w, h = img.size
+
+try:
+    data = json.load(open(extradata, "r"))
+except:
+    sys.stderr.write("mapconv: Invalid extradata JSON!\n")
+    sys.exit(1)
+
+def getcolor(color: str):
+    try:
+        return int(color[1:], 16)
+    except Exception as e:
+        print(e)
+        sys.stderr.write("mapconv: Invalid color!\n")
+        sys.exit(1)
+
+tilecolors = []
+textures = []
+tileset = []
+sprites = []
+
+def gettexture(name: str):
+    if len(name.encode()) >= NAME_MAX:
+        sys.stderr.write(f"mapconv: Texture name too long: {name}!\n")
+        sys.exit(1)
+    if name not in textures:
+        textures.append(name)
+    return textures.index(name)
+
+try:
+    for i in data["tiles"]:
+        tilecolors.append(getcolor(i["color"]))
+        tileset.append(gettexture(i["texture"]))
+    for i in data["sprites"]:
+        sprites.append((round(i["x"]*65536), round(i["y"]*65536),
+                        gettexture(i["texture"]),
+                        VISIBLE if i["visible"] else 0))
+except Exception as e:
+    print(e)
+    sys.stderr.write("mapconv: Invalid extradata!\n")
+    sys.exit(1)
+
+def getlayer(img):
+    layer = bytearray()
+    try:
+        for y in range(h):
+            for x in range(w):
+                pixel = img.getpixel((x, y))
+                color = pixel[0]<<16|pixel[1]<<8|pixel[2]
+                idx = 0
+                if color != 0xFFFFFF:
+                    idx = tilecolors.index(color)+1
+                layer.append(idx)
+    except Exception as e:
+        print(e)
+        sys.stderr.write("mapconv: Invalid extradata!\n")
+        sys.exit(1)
+    return bytes(layer)
+
+mapdata = getlayer(img)
+
+def getchunks(layer):
+    out = bytearray(struct.pack("<I", chunksize))
+    for cy in range(0, h, chunksize):
+        for cx in range(0, w, chunksize):
+            for y in range(cy, cy+chunksize):
+                row = b""
+                if y < h:
+                    row = layer[y*w+cx:y*w+min(cx+chunksize, w)]
+                out += row.ljust(chunksize, b"\0")
+    return bytes(out)
+
+if chunksize:
+    sections = [(CHUNKS, getchunks(mapdata))]
+else:
+    sections = [(DATA, mapdata)]
+
+# Optional floor and ceiling layers, like in mapgen.py.
+for i, section in [("floor", FLOOR), ("ceiling", CEILING)]:
+    if i not in data:
+        continue
+    layerimg = Image.open(os.path.join(os.path.dirname(extradata),
+                                       data[i])).convert("RGB")
+    if layerimg.size != img.size:
+        sys.stderr.write(f"mapconv: The {i} and the map sizes differ!\n")
+        sys.exit(1)
+    sections.append((section, getlayer(layerimg)))
+
+out = struct.pack("<I", len(textures))
+for i in textures:
+    out += i.encode().ljust(NAME_MAX, b"\0")
+sections.append((TEXTURES, out))
+
+out = struct.pack("<I", len(tileset))
+for i in tileset:
+    out += struct.pack("<I", i)
+sections.append((TILESET, out))
+
+out = struct.pack("<I", len(sprites))
+for i in sprites:
+    out += struct.pack("<iiII", *i)
+sections.append((SPRITES, out))
+
+out = b"RMAP"+struct.pack("<IIII", VERSION, w, h, len(sections))
+offset = len(out)+12*len(sections)
+for section, content in sections:
+    out += struct.pack("<III", section, offset, len(content))
+    offset += len(content)
+for section, content in sections:
+    out += content
+
+with open(output, "wb") as fp:
+    fp.write(out)
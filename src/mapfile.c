@@ -0,0 +1,295 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* mmap, open and fstat are POSIX. */
+#define _POSIX_C_SOURCE 200112L
+
+#include <mapfile.h>
+#if TEXPACK
+#include <texpack.h>
+#endif
+
+#if MAPFILE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define HEADER_SIZE 20
+#define SECTION_SIZE 12
+#define SPRITE_SIZE 16
+
+unsigned long _mapfile_u32(const unsigned char *p) {
+    return (unsigned long)p[0] | (unsigned long)p[1]<<8 |
+           (unsigned long)p[2]<<16 | (unsigned long)p[3]<<24;
+}
+
+/* Check that a section of size bytes starts with a count of n items of
+ * item_size bytes. */
+int _mapfile_check_table(unsigned long size, unsigned long n,
+                         unsigned long item_size) {
+    return size >= 4 && n <= (size-4)/item_size;
+}
+
+int _mapfile_error(MapFile *file, const char *path, const char *error) {
+    fprintf(stderr, "[mapfile] %s: %s\n", path, error);
+    mapfile_free(file);
+    return -1;
+}
+
+int mapfile_load(MapFile *file, const char *path, MapTexture *textures,
+                 int texture_num, struct TexPack *pack) {
+    int fd;
+    struct stat st;
+    unsigned char *mem;
+    unsigned char *p;
+    unsigned long i, n;
+    unsigned long width, height;
+    unsigned long sections;
+    unsigned long type, offset, size;
+    unsigned long texture_count = 0;
+    unsigned long tile_count = 0;
+    unsigned long sprite_count = 0;
+    unsigned char *names = NULL;
+    unsigned char *tiles = NULL;
+    unsigned char *sprites = NULL;
+    unsigned long chunk_size = 0;
+    unsigned long chunk_offset = 0;
+    unsigned long chunk_num;
+    Texture **found = NULL;
+    Map *map = &file->map;
+#if !TEXPACK
+    (void)pack;
+#endif
+    memset(file, 0, sizeof(MapFile));
+    fd = open(path, O_RDONLY);
+    if(fd < 0) return _mapfile_error(file, path, "Failed to open the file!");
+    if(fstat(fd, &st) || st.st_size < HEADER_SIZE){
+        close(fd);
+        return _mapfile_error(file, path, "Not a map file!");
+    }
+    /* Mapped privately and writable, so that the tiles can be changed. */
+    mem = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mem == MAP_FAILED){
+        return _mapfile_error(file, path, "Failed to map the file!");
+    }
+    file->mem = mem;
+    file->size = st.st_size;
+    if(memcmp(mem, "RMAP", 4)){
+        return _mapfile_error(file, path, "Not a map file!");
+    }
+    if(_mapfile_u32(mem+4) != MAPFILE_VERSION){
+        return _mapfile_error(file, path, "Unsupported version!");
+    }
+    width = _mapfile_u32(mem+8);
+    height = _mapfile_u32(mem+12);
+    sections = _mapfile_u32(mem+16);
+    if(!width || !height || width > 0x7FFF || height > 0x7FFF ||
+       sections > (file->size-HEADER_SIZE)/SECTION_SIZE){
+        return _mapfile_error(file, path, "Invalid header!");
+    }
+    for(i=0;i<sections;i++){
+        p = mem+HEADER_SIZE+i*SECTION_SIZE;
+        type = _mapfile_u32(p);
+        offset = _mapfile_u32(p+4);
+        size = _mapfile_u32(p+8);
+        if(offset > file->size || size > file->size-offset){
+            return _mapfile_error(file, path, "Section out of the file!");
+        }
+        p = mem+offset;
+        switch(type){
+            case MAPFILE_DATA:
+            case MAPFILE_FLOOR:
+            case MAPFILE_CEILING:
+                if(size != width*height){
+                    return _mapfile_error(file, path, "Invalid layer size!");
+                }
+                if(type == MAPFILE_DATA) map->data = p;
+                else if(type == MAPFILE_FLOOR) map->floor = p;
+                else map->ceiling = p;
+                break;
+            case MAPFILE_TEXTURES:
+                texture_count = size >= 4 ? _mapfile_u32(p) : 0;
+                if(!_mapfile_check_table(size, texture_count,
+                                         MAPFILE_NAME_MAX)){
+                    return _mapfile_error(file, path, "Invalid textures!");
+                }
+                names = p+4;
+                break;
+            case MAPFILE_TILESET:
+                tile_count = size >= 4 ? _mapfile_u32(p) : 0;
+                if(!_mapfile_check_table(size, tile_count, 4)){
+                    return _mapfile_error(file, path, "Invalid tileset!");
+                }
+                tiles = p+4;
+                break;
+            case MAPFILE_SPRITES:
+                sprite_count = size >= 4 ? _mapfile_u32(p) : 0;
+                if(!_mapfile_check_table(size, sprite_count, SPRITE_SIZE)){
+                    return _mapfile_error(file, path, "Invalid sprites!");
+                }
+                sprites = p+4;
+                break;
+#if CHUNKMAP
+            case MAPFILE_CHUNKS:
+                chunk_size = size >= 4 ? _mapfile_u32(p) : 0;
+                if(!chunk_size || chunk_size > 0x1000 ||
+                   (chunk_size&(chunk_size-1))){
+                    return _mapfile_error(file, path, "Invalid chunks!");
+                }
+                chunk_num = ((width+chunk_size-1)/chunk_size)*
+                            ((height+chunk_size-1)/chunk_size);
+                if(size-4 != chunk_num*chunk_size*chunk_size){
+                    return _mapfile_error(file, path, "Invalid chunks!");
+                }
+                chunk_offset = offset+4;
+                break;
+#endif
+        }
+    }
+    if(!map->data && !chunk_size){
+        return _mapfile_error(file, path, "No walls!");
+    }
+    /* Find the textures. */
+    if(texture_count){
+        found = malloc(texture_count*sizeof(Texture*));
+        if(!found){
+            return _mapfile_error(file, path,
+                                  "Failed to allocate the textures!");
+        }
+    }
+    for(i=0;i<texture_count;i++){
+        p = names+i*MAPFILE_NAME_MAX;
+        found[i] = NULL;
+#if TEXPACK
+        /* Only the textures used by the map are decoded. */
+        if(pack){
+            found[i] = texpack_texture(pack, texpack_find(pack, (char*)p), 0);
+        }
+#endif
+        for(n=0;!found[i] && n<(unsigned long)texture_num;n++){
+            if(!strncmp((char*)p, textures[n].name, MAPFILE_NAME_MAX)){
+                found[i] = textures[n].texture;
+                break;
+            }
+        }
+        if(!found[i]){
+            free(found);
+            return _mapfile_error(file, path, "Unknown texture!");
+        }
+    }
+    /* The tileset and the sprites contain pointers, so they can't be used
+     * from the file directly. */
+    map->tileset = malloc((tile_count ? tile_count : 1)*sizeof(Tile));
+    map->sprites = malloc((sprite_count ? sprite_count : 1)*sizeof(Sprite));
+    if(!map->tileset || !map->sprites){
+        free(found);
+        return _mapfile_error(file, path, "Failed to allocate the map!");
+    }
+    for(i=0;i<tile_count;i++){
+        n = _mapfile_u32(tiles+i*4);
+        if(n >= texture_count){
+            free(found);
+            return _mapfile_error(file, path, "Invalid tile texture!");
+        }
+        map->tileset[i].texture = found[n];
+        map->tileset[i].extra_data = NULL;
+    }
+    for(i=0;i<sprite_count;i++){
+        p = sprites+i*SPRITE_SIZE;
+        n = _mapfile_u32(p+8);
+        if(n >= texture_count){
+            free(found);
+            return _mapfile_error(file, path, "Invalid sprite texture!");
+        }
+        map->sprites[i].x = (fixed_t)(int32_t)_mapfile_u32(p)>>
+                            (16-PRECISION);
+        map->sprites[i].y = (fixed_t)(int32_t)_mapfile_u32(p+4)>>
+                            (16-PRECISION);
+        map->sprites[i].texture = found[n];
+        map->sprites[i].visible = _mapfile_u32(p+12)&MAPFILE_VISIBLE;
+        map->sprites[i].extra_data = NULL;
+    }
+    free(found);
+#if CHUNKMAP
+    /* The walls of streamed maps are checked when their chunks are loaded. */
+    if(!map->data){
+        map->chunks = malloc(sizeof(ChunkMap));
+        if(!map->chunks){
+            return _mapfile_error(file, path, "Failed to allocate the map!");
+        }
+        if(chunkmap_open(map->chunks, path, chunk_offset, width, height,
+                         chunk_size, CHUNKMAP_BUDGET)){
+            free(map->chunks);
+            map->chunks = NULL;
+            return _mapfile_error(file, path, "Failed to open the chunks!");
+        }
+        map->chunks->max_tile = tile_count;
+    }
+#endif
+    /* Every tile has to be in the tileset. */
+    for(i=0;(map->data || map->floor || map->ceiling) && i<width*height;i++){
+        if((map->data && map->data[i] > tile_count) ||
+           (map->floor && map->floor[i] > tile_count) ||
+           (map->ceiling && map->ceiling[i] > tile_count)){
+            return _mapfile_error(file, path, "Invalid tile!");
+        }
+    }
+    map->width = width;
+    map->height = height;
+    map->sprite_num = sprite_count;
+    map->extra_data = NULL;
+    map->revision = 0;
+    return 0;
+}
+
+void mapfile_free(MapFile *file) {
+#if CHUNKMAP
+    if(file->map.chunks){
+        chunkmap_close(file->map.chunks);
+        free(file->map.chunks);
+    }
+#endif
+    if(file->mem) munmap(file->mem, file->size);
+    free(file->map.tileset);
+    free(file->map.sprites);
+    memset(file, 0, sizeof(MapFile));
+}
+
+#endif
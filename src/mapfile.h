@@ -0,0 +1,122 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef MAPFILE_H
+#define MAPFILE_H
+
+#include <map.h>
+#include <texture.h>
+
+#include <stddef.h>
+
+/* Binary map files.
+ *
+ * All the integers are stored in little endian. A file starts with a header:
+ *
+ * offset size
+ * 0      4    magic, "RMAP"
+ * 4      4    version, MAPFILE_VERSION
+ * 8      4    width of the map in cells
+ * 12     4    height of the map in cells
+ * 16     4    number of sections
+ *
+ * followed by the section table, 12 bytes for each section: type, offset of
+ * the section from the start of the file and size in bytes. Unknown sections
+ * are skipped. The sections are:
+ *
+ * MAPFILE_DATA     width*height bytes, the walls (0 for an empty cell, n for
+ *                  the n-th tile of the tileset).
+ * MAPFILE_FLOOR    width*height bytes, the floor (optional).
+ * MAPFILE_CEILING  width*height bytes, the ceiling (optional).
+ * MAPFILE_TEXTURES number of textures, then MAPFILE_NAME_MAX bytes for the
+ *                  name of each texture, padded with zeros.
+ * MAPFILE_TILESET  number of tiles, then the index of the texture of each
+ *                  tile.
+ * MAPFILE_SPRITES  number of sprites, then 16 bytes for each sprite: x and y
+ *                  in 16.16 fixed point, index of its texture and flags
+ *                  (MAPFILE_VISIBLE).
+ * MAPFILE_CHUNKS   the size of a chunk in cells (a power of two), then the
+ *                  walls by chunks of size by size cells, row by row. The
+ *                  chunks at the right and bottom edges are padded with
+ *                  zeros. Used instead of MAPFILE_DATA for maps that are too
+ *                  big to be kept in memory, needs CHUNKMAP. The chunks are
+ *                  streamed from the file and the tiles can only be accessed
+ *                  with MAP_TILE, map_get_tile and map_set_tile.
+ *
+ * The layers are used directly from the mapped file, the file is mapped
+ * privately so that they can still be modified. */
+
+#define MAPFILE_VERSION 1
+#define MAPFILE_NAME_MAX 32
+
+enum {
+    MAPFILE_DATA = 1,
+    MAPFILE_FLOOR,
+    MAPFILE_CEILING,
+    MAPFILE_TEXTURES,
+    MAPFILE_TILESET,
+    MAPFILE_SPRITES,
+    /* 7 held the blocks of cells with walls, now skipped. */
+    MAPFILE_CHUNKS = 8
+};
+
+enum {
+    MAPFILE_VISIBLE = 1
+};
+
+/* Used to find the textures named in the file. */
+typedef struct {
+    const char *name;
+    Texture *texture;
+} MapTexture;
+
+typedef struct {
+    Map map;
+    void *mem;
+    size_t size;
+} MapFile;
+
+struct TexPack;
+
+/* Load the map file at path. Its texture names are looked up in the texture
+ * pack if pack is not NULL (see texpack.h), then in textures. The pack has to
+ * stay open while the map is used. Streamed maps keep at most
+ * CHUNKMAP_BUDGET chunks in memory. Returns 0 on success, prints an error and
+ * returns -1 on failure. */
+int mapfile_load(MapFile *file, const char *path, MapTexture *textures,
+                 int texture_num, struct TexPack *pack);
+
+void mapfile_free(MapFile *file);
+
+#endif
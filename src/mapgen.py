@@ -39,8 +39,6 @@ import json
 INDENT = 4
 MAX_COLUMN = 79 # Column 80 for line feed.
 
-column = 4
-
 if len(sys.argv) < 5:
     sys.stderr.write("USAGE: mapgen [MAP] [EXTRADATA] [C SOURCE] [C HEADER]\n")
     sys.exit(1)
@@ -56,8 +54,6 @@ img = Image.open(infile).convert("RGB")
 
 w, h = img.size
 
-mapdata = []
-
 try:
     data = json.load(open(extradata, "r"))
 except:
@@ -84,19 +80,38 @@ except Exception as e:
     sys.stderr.write("mapgen: Invalid extradata!\n")
     sys.exit(1)
 
-try:
-    for y in range(h):
-        for x in range(w):
-            pixel = img.getpixel((x, y))
-            color = pixel[0]<<16|pixel[1]<<8|pixel[2]
-            idx = 0
-            if color != 0xFFFFFF: 
-                idx = tilecolors.index(color)+1
-            mapdata.append(idx)
-except Exception as e:
-    print(e)
-    sys.stderr.write("mapgen: Invalid extradata!\n")
-    sys.exit(1)
+def getlayer(img):
+    layer = []
+    try:
+        for y in range(h):
+            for x in range(w):
+                pixel = img.getpixel((x, y))
+                color = pixel[0]<<16|pixel[1]<<8|pixel[2]
+                idx = 0
+                if color != 0xFFFFFF: 
+                    idx = tilecolors.index(color)+1
+                layer.append(idx)
+    except Exception as e:
+        print(e)
+        sys.stderr.write("mapgen: Invalid extradata!\n")
+        sys.exit(1)
+    return layer
+
+mapdata = getlayer(img)
+
+# Optional floor and ceiling layers, stored as images of the same size as the
+# map, relative to the extradata file.
+layers = {}
+
+for i in ["floor", "ceiling"]:
+    if i not in data:
+        continue
+    layerimg = Image.open(os.path.join(os.path.dirname(extradata),
+                                       data[i])).convert("RGB")
+    if layerimg.size != img.size:
+        sys.stderr.write(f"mapgen: The {i} and the map sizes differ!\n")
+        sys.exit(1)
+    layers[i] = getlayer(layerimg)
 
 out = f"""#include <map.h>
 #include <stddef.h>
@@ -145,42 +160,57 @@ try:
     sprites = len(data["sprites"])
     for i in data["sprites"]:
         out += " "*INDENT
-        out += (f"{{TO_FIXED({i['x']}), TO_FIXED({i['y']}), 0, " +
-                f"&{i['texture']}, {int(i['visible'])}, 0, 0, NULL}},\n")
+        out += (f"{{TO_FIXED({i['x']}), TO_FIXED({i['y']}), " +
+                f"&{i['texture']}, {int(i['visible'])}, NULL}},\n")
     out = out[:-2]
 except Exception as e:
     print(e)
     sys.stderr.write("mapgen: Invalid extradata!\n")
     sys.exit(1)
 
-out += f"""
+def genlayer(layername, layer):
+    out = f"""
 }};
 
-unsigned char {name.lower()}_data[{w*h}] = {{
+unsigned char {name.lower()}_{layername}[{w*h}] = {{
 """
-
-out += ' '*INDENT
-for n in range(len(mapdata)):
-    i = mapdata[n]
-    string = f"{hex(i)}, "
-    if n >= len(mapdata)-1:
-        string = string[:-2]
-    if column+len(string) >= MAX_COLUMN:
-        out = out[:-1]
-        out += '\n'
-        out += ' '*INDENT
-        column = INDENT
-    out += string
-    column += len(string)
+    column = INDENT
+    out += ' '*INDENT
+    for n in range(len(layer)):
+        i = layer[n]
+        string = f"{hex(i)}, "
+        if n >= len(layer)-1:
+            string = string[:-2]
+        if column+len(string) >= MAX_COLUMN:
+            out = out[:-1]
+            out += '\n'
+            out += ' '*INDENT
+            column = INDENT
+        out += string
+        column += len(string)
+    return out
+
+out += genlayer("data", mapdata)
+
+for i in layers:
+    out += genlayer(i, layers[i])
+
+def layerptr(layername):
+    if layername in layers:
+        return f"{name.lower()}_{layername}"
+    return "NULL"
 
 out += f"""
 }};
 
 Map {name.lower()} = {{
     {name.lower()}_data,
+    {layerptr("floor")}, {layerptr("ceiling")},
     {w}, {h},
     {name.lower()}_tileset,
     {name.lower()}_sprites, {sprites},
+    NULL,
+    0,
     NULL
 }};\n
 """
@@ -0,0 +1,119 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* syscall is not POSIX. */
+#define _DEFAULT_SOURCE
+
+#include <perfcount.h>
+
+#if PERFCOUNT
+
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#define CACHE_READ_MISS(cache) ((cache) | PERF_COUNT_HW_CACHE_OP_READ<<8 | \
+                                PERF_COUNT_HW_CACHE_RESULT_MISS<<16)
+
+const struct {
+    unsigned int type;
+    unsigned long config;
+    const char *name;
+} _perf_events[PERF_EVENTS] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, "instr"},
+    {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D), "l1d-miss"},
+    {PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL), "llc-miss"},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, "br-miss"}
+};
+
+int perfcount_open(PerfCounters *counters) {
+    struct perf_event_attr attr;
+    int i;
+    counters->leader = -1;
+    counters->num = 0;
+    for(i=0;i<PERF_EVENTS;i++){
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = _perf_events[i].type;
+        attr.config = _perf_events[i].config;
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.disabled = counters->leader < 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        counters->fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1,
+                                   counters->leader, 0);
+        if(counters->fds[i] < 0) continue;
+        if(counters->leader < 0) counters->leader = counters->fds[i];
+        counters->slots[i] = counters->num++;
+    }
+    if(counters->leader >= 0){
+        ioctl(counters->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(counters->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    return counters->num;
+}
+
+void perfcount_read(PerfCounters *counters, unsigned long *values) {
+    /* The number of events followed by their values. */
+    uint64_t buf[PERF_EVENTS+1];
+    int i;
+    if(counters->leader < 0 ||
+       read(counters->leader, buf, sizeof(buf)) < (long)sizeof(uint64_t)){
+        for(i=0;i<PERF_EVENTS;i++) values[i] = 0;
+        return;
+    }
+    for(i=0;i<PERF_EVENTS;i++){
+        values[i] = counters->fds[i] < 0 ? 0 : buf[1+counters->slots[i]];
+    }
+}
+
+void perfcount_close(PerfCounters *counters) {
+    int i;
+    for(i=0;i<PERF_EVENTS;i++){
+        if(counters->fds[i] >= 0) close(counters->fds[i]);
+        counters->fds[i] = -1;
+    }
+    counters->leader = -1;
+    counters->num = 0;
+}
+
+const char *perfcount_name(int event) {
+    return _perf_events[event].name;
+}
+
+#endif
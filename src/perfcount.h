@@ -0,0 +1,79 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PERFCOUNT_H
+#define PERFCOUNT_H
+
+#include <config.h>
+
+#if PERFCOUNT
+
+/* Hardware performance counters of the calling thread, read with Linux's
+ * perf_event_open. The events are opened as a group, so that they are
+ * counted over the same time and read with a single system call. */
+
+enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES, /* Level 1 data cache read misses. */
+    PERF_LLC_MISSES, /* Last level cache read misses. */
+    PERF_BRANCH_MISSES,
+    PERF_EVENTS
+};
+
+typedef struct {
+    int fds[PERF_EVENTS]; /* -1 for the events that are not available. */
+    int leader; /* The first event opened, -1 if there is none. */
+    /* The position of each event in the values read from the group. */
+    int slots[PERF_EVENTS];
+    int num;
+} PerfCounters;
+
+/* Open and start the counters of the calling thread. Returns the number of
+ * events available, which is 0 if the kernel or the processor doesn't
+ * provide them (for example in most virtual machines). */
+int perfcount_open(PerfCounters *counters);
+
+/* Store the current value of each event in values, 0 for the ones that are
+ * not available. */
+void perfcount_read(PerfCounters *counters, unsigned long *values);
+
+void perfcount_close(PerfCounters *counters);
+
+/* A short name for the event. */
+const char *perfcount_name(int event);
+
+#endif
+
+#endif
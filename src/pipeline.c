@@ -0,0 +1,271 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* pthreads and clock_gettime are POSIX. */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pipeline.h>
+
+#if PIPELINE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+/* Set in the middle slot of an Exchange when it holds a result that the
+ * consumer did not take yet. */
+#define FRESH 4
+
+/* A triple buffer. The producer owns the slot back, the consumer the slot
+ * front, and they swap their slot with middle with an atomic exchange. The
+ * lock and the condition are only used to sleep when there is nothing to
+ * do. */
+typedef struct {
+    int back;
+    int front;
+    int middle;
+    char closed;
+    char wait_taken; /* Wait until the consumer took a result to publish. */
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} Exchange;
+
+typedef struct {
+    Pipeline *pipeline;
+    int mode;
+    char stop;
+    unsigned char *snapshots;
+    /* The time at which the simulation of the state started, for each
+     * snapshot and for each framebuffer. */
+    unsigned long snapshot_us[3];
+    unsigned long frame_us[3];
+    Exchange states;
+    Exchange frames;
+    PipelineStats stats;
+} Run;
+
+unsigned long _pipeline_us(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (unsigned long)t.tv_sec*1000000UL+t.tv_nsec/1000;
+}
+
+void _exchange_init(Exchange *e, char wait_taken) {
+    e->back = 0;
+    e->middle = 1;
+    e->front = 2;
+    e->closed = 0;
+    e->wait_taken = wait_taken;
+    pthread_mutex_init(&e->lock, NULL);
+    pthread_cond_init(&e->cond, NULL);
+}
+
+void _exchange_free(Exchange *e) {
+    pthread_mutex_destroy(&e->lock);
+    pthread_cond_destroy(&e->cond);
+}
+
+void _exchange_wake(Exchange *e) {
+    pthread_mutex_lock(&e->lock);
+    pthread_cond_broadcast(&e->cond);
+    pthread_mutex_unlock(&e->lock);
+}
+
+/* Publish the slot back of the producer, which gets another one. */
+void _exchange_publish(Exchange *e) {
+    if(e->wait_taken){
+        pthread_mutex_lock(&e->lock);
+        while(!e->closed &&
+              __atomic_load_n(&e->middle, __ATOMIC_ACQUIRE)&FRESH){
+            pthread_cond_wait(&e->cond, &e->lock);
+        }
+        pthread_mutex_unlock(&e->lock);
+    }
+    e->back = __atomic_exchange_n(&e->middle, e->back|FRESH,
+                                  __ATOMIC_ACQ_REL)&3;
+    _exchange_wake(e);
+}
+
+/* Wait for a new result and return its slot, or -1 if the producer closed
+ * the exchange. */
+int _exchange_take(Exchange *e) {
+    pthread_mutex_lock(&e->lock);
+    while(!(__atomic_load_n(&e->middle, __ATOMIC_ACQUIRE)&FRESH)){
+        if(e->closed){
+            pthread_mutex_unlock(&e->lock);
+            return -1;
+        }
+        pthread_cond_wait(&e->cond, &e->lock);
+    }
+    pthread_mutex_unlock(&e->lock);
+    e->front = __atomic_exchange_n(&e->middle, e->front, __ATOMIC_ACQ_REL)&3;
+    if(e->wait_taken) _exchange_wake(e);
+    return e->front;
+}
+
+void _exchange_close(Exchange *e) {
+    pthread_mutex_lock(&e->lock);
+    e->closed = 1;
+    pthread_cond_broadcast(&e->cond);
+    pthread_mutex_unlock(&e->lock);
+}
+
+void *_pipeline_simulate(void *arg) {
+    Run *run = arg;
+    Pipeline *pipeline = run->pipeline;
+    unsigned char *previous = NULL;
+    int slot;
+    while(!__atomic_load_n(&run->stop, __ATOMIC_ACQUIRE)){
+        slot = run->states.back;
+        run->snapshot_us[slot] = _pipeline_us();
+        if(!pipeline->simulate(run->snapshots+slot*pipeline->snapshot_size,
+                               previous, pipeline->data)) break;
+        run->stats.simulated++;
+        _exchange_publish(&run->states);
+        /* The slot stays ours until the next publication, so the next state
+         * is computed from the one we just published. */
+        previous = run->snapshots+slot*pipeline->snapshot_size;
+    }
+    _exchange_close(&run->states);
+    return NULL;
+}
+
+void *_pipeline_render(void *arg) {
+    Run *run = arg;
+    Pipeline *pipeline = run->pipeline;
+    int slot;
+    while((slot = _exchange_take(&run->states)) >= 0){
+        pipeline->render(run->snapshots+slot*pipeline->snapshot_size,
+                         run->frames.back, pipeline->data);
+        run->frame_us[run->frames.back] = run->snapshot_us[slot];
+        run->stats.rendered++;
+        _exchange_publish(&run->frames);
+    }
+    _exchange_close(&run->frames);
+    return NULL;
+}
+
+void _pipeline_presented(Run *run, unsigned long start) {
+    unsigned long latency = _pipeline_us()-start;
+    run->stats.presented++;
+    run->stats.latency_avg += latency;
+    if(latency > run->stats.latency_max) run->stats.latency_max = latency;
+}
+
+void _pipeline_serial(Run *run) {
+    Pipeline *pipeline = run->pipeline;
+    unsigned char *previous = NULL;
+    unsigned char *snapshot;
+    unsigned long start;
+    int slot = 0;
+    for(;;){
+        snapshot = run->snapshots+slot*pipeline->snapshot_size;
+        start = _pipeline_us();
+        if(!pipeline->simulate(snapshot, previous, pipeline->data)) break;
+        run->stats.simulated++;
+        pipeline->render(snapshot, 0, pipeline->data);
+        run->stats.rendered++;
+        if(!pipeline->present(0, pipeline->data)) break;
+        _pipeline_presented(run, start);
+        previous = snapshot;
+        slot = !slot;
+    }
+}
+
+int _pipeline_threaded(Run *run) {
+    Pipeline *pipeline = run->pipeline;
+    pthread_t simulation, render;
+    int buffer;
+    char wait_taken = run->mode == PIPELINE_DOUBLE;
+    _exchange_init(&run->states, wait_taken);
+    _exchange_init(&run->frames, wait_taken);
+    if(pthread_create(&simulation, NULL, _pipeline_simulate, run)){
+        fputs("[pipeline] Failed to start the simulation thread!\n", stderr);
+        _exchange_free(&run->states);
+        _exchange_free(&run->frames);
+        return -1;
+    }
+    if(pthread_create(&render, NULL, _pipeline_render, run)){
+        fputs("[pipeline] Failed to start the render thread!\n", stderr);
+        __atomic_store_n(&run->stop, 1, __ATOMIC_RELEASE);
+        _exchange_close(&run->states);
+        pthread_join(simulation, NULL);
+        _exchange_free(&run->states);
+        _exchange_free(&run->frames);
+        return -1;
+    }
+    while((buffer = _exchange_take(&run->frames)) >= 0){
+        if(!pipeline->present(buffer, pipeline->data)) break;
+        _pipeline_presented(run, run->frame_us[buffer]);
+    }
+    /* Unblock the other stages if present asked to stop. */
+    __atomic_store_n(&run->stop, 1, __ATOMIC_RELEASE);
+    _exchange_close(&run->states);
+    _exchange_close(&run->frames);
+    pthread_join(simulation, NULL);
+    pthread_join(render, NULL);
+    _exchange_free(&run->states);
+    _exchange_free(&run->frames);
+    return 0;
+}
+
+int pipeline_run(Pipeline *pipeline, int mode, PipelineStats *stats) {
+    Run run;
+    unsigned long start;
+    int ret = 0;
+    run.pipeline = pipeline;
+    run.mode = mode;
+    run.stop = 0;
+    run.stats.simulated = 0;
+    run.stats.rendered = 0;
+    run.stats.presented = 0;
+    run.stats.latency_avg = 0;
+    run.stats.latency_max = 0;
+    run.snapshots = malloc(3*pipeline->snapshot_size);
+    if(!run.snapshots){
+        fputs("[pipeline] Failed to allocate the snapshots!\n", stderr);
+        exit(-1);
+    }
+    start = _pipeline_us();
+    if(mode == PIPELINE_SERIAL) _pipeline_serial(&run);
+    else ret = _pipeline_threaded(&run);
+    run.stats.us = _pipeline_us()-start;
+    if(run.stats.presented) run.stats.latency_avg /= run.stats.presented;
+    free(run.snapshots);
+    if(stats) *stats = run.stats;
+    return ret;
+}
+
+#endif
@@ -0,0 +1,95 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <config.h>
+
+#if PIPELINE
+
+/* Run the frames of a game in three stages: simulate, render and present.
+ * Except in PIPELINE_SERIAL, the simulation and the rendering have their own
+ * thread and present runs on the calling thread (which is the only one that
+ * can use the window with SDL). The stages hand over their results through
+ * triple buffers: the producer writes into its own slot and swaps it with the
+ * shared middle slot with an atomic exchange, the consumer swaps the middle
+ * slot with its own when it is newer. So the simulation of the frame N+1
+ * runs while the frame N is rendered and the frame N-1 presented. */
+
+enum {
+    /* Simulate, render and present one after the other on the calling
+     * thread. */
+    PIPELINE_SERIAL,
+    /* Each stage waits until the next one took its last result, so that
+     * every simulated state is rendered and presented. */
+    PIPELINE_DOUBLE,
+    /* The stages never wait for the next one, which uses the most recent
+     * result and skips the others. simulate should wait for its next tick
+     * itself. */
+    PIPELINE_TRIPLE
+};
+
+typedef struct {
+    /* Compute the next state of the simulation into snapshot, with the
+     * previous state in previous (NULL the first time). Returns 0 to
+     * stop. */
+    int (*simulate)(void *snapshot, const void *previous, void *data);
+    /* Draw snapshot into the framebuffer number buffer (0 to 2). */
+    void (*render)(const void *snapshot, int buffer, void *data);
+    /* Show the framebuffer number buffer. Returns 0 to stop. */
+    int (*present)(int buffer, void *data);
+    int snapshot_size;
+    void *data;
+} Pipeline;
+
+typedef struct {
+    unsigned long simulated; /* States computed. */
+    unsigned long rendered; /* States rendered. */
+    unsigned long presented; /* Frames presented. */
+    /* Time from the start of the simulation of a state to the end of the
+     * presentation of its frame, in microseconds. */
+    unsigned long latency_avg;
+    unsigned long latency_max;
+    unsigned long us; /* Total time. */
+} PipelineStats;
+
+/* Run the stages of pipeline in the given mode until simulate or present
+ * returns 0. The stats are stored in stats if it isn't NULL. Returns 0 on
+ * success, prints an error and returns -1 on failure. */
+int pipeline_run(Pipeline *pipeline, int mode, PipelineStats *stats);
+
+#endif
+
+#endif
@@ -0,0 +1,201 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <profile.h>
+
+#include <stdio.h>
+#include <string.h>
+
+const char *_profile_stages[PROFILE_STAGES] = {
+    "rays", "walls", "spans", "sprites", "present"
+};
+
+void profile_init(Profile *profile) {
+    int i;
+    profile->variant = "none";
+    profile->rays = 0;
+    profile->width = 0;
+    profile->height = 0;
+    profile->rays_cast = 0;
+    for(i=0;i<PROFILE_STAGES;i++){
+        profile->us[i] = 0;
+        profile->frame[i] = 0;
+        profile->start[i] = 0;
+    }
+    profile->worker_num = 0;
+    for(i=0;i<PROFILE_WORKERS;i++) profile->worker_busy[i] = 0;
+#if PERFCOUNT
+    profile->counters = NULL;
+    profile->frames = 0;
+    memset(profile->events, 0, sizeof(profile->events));
+    memset(profile->events_last, 0, sizeof(profile->events_last));
+    memset(profile->events_total, 0, sizeof(profile->events_total));
+#endif
+}
+
+void profile_begin_frame(Profile *profile) {
+    int i;
+    profile->rays_cast = 0;
+    profile->worker_num = 0;
+    /* The presentation of the last frame is kept until the end of this
+     * one. */
+    for(i=0;i<PROFILE_PRESENT;i++){
+        profile->frame[i] = 0;
+#if PERFCOUNT
+        memset(profile->events[i], 0, sizeof(profile->events[i]));
+#endif
+    }
+}
+
+void profile_end_frame(Profile *profile) {
+    int i;
+#if PERFCOUNT
+    int e;
+#endif
+    /* Exponential moving average over ~8 frames. */
+    for(i=0;i<PROFILE_STAGES;i++){
+        profile->us[i] = (profile->us[i]*7+profile->frame[i])/8;
+    }
+    profile->frame[PROFILE_PRESENT] = 0;
+#if PERFCOUNT
+    if(!profile->counters) return;
+    for(i=0;i<PROFILE_STAGES;i++){
+        for(e=0;e<PERF_EVENTS;e++){
+            profile->events_last[i][e] = profile->events[i][e];
+            profile->events_total[i][e] += profile->events[i][e];
+        }
+    }
+    memset(profile->events[PROFILE_PRESENT], 0,
+           sizeof(profile->events[PROFILE_PRESENT]));
+    profile->frames++;
+#endif
+}
+
+void profile_start(Profile *profile, int stage, unsigned long now) {
+    profile->start[stage] = now;
+#if PERFCOUNT
+    if(profile->counters){
+        perfcount_read(profile->counters, profile->events_start[stage]);
+    }
+#endif
+}
+
+void profile_stop(Profile *profile, int stage, unsigned long now) {
+#if PERFCOUNT
+    unsigned long values[PERF_EVENTS];
+    int e;
+    if(profile->counters){
+        perfcount_read(profile->counters, values);
+        for(e=0;e<PERF_EVENTS;e++){
+            profile->events[stage][e] += values[e]-
+                                         profile->events_start[stage][e];
+        }
+    }
+#endif
+    profile->frame[stage] += now-profile->start[stage];
+}
+
+void profile_merge(Profile *profile, Profile *other) {
+    int i;
+#if PERFCOUNT
+    int e;
+#endif
+    profile->rays_cast += other->rays_cast;
+    /* The presentation is not part of the frames being merged. */
+    for(i=0;i<PROFILE_PRESENT;i++) profile->frame[i] += other->frame[i];
+#if PERFCOUNT
+    if(!other->counters) return;
+    for(i=0;i<PROFILE_PRESENT;i++){
+        for(e=0;e<PERF_EVENTS;e++){
+            profile->events[i][e] += other->events[i][e];
+        }
+    }
+#endif
+}
+
+void profile_workers(Profile *profile, int n, const unsigned long *busy,
+                     unsigned long us) {
+    int i;
+    if(n > PROFILE_WORKERS) n = PROFILE_WORKERS;
+    profile->worker_num = n;
+    if(!us) return;
+    for(i=0;i<n;i++){
+        profile->worker_busy[i] = (profile->worker_busy[i]*7+
+                                   busy[i]*100/us)/8;
+    }
+}
+
+void profile_format(Profile *profile, char *buf) {
+    int i;
+    size_t len;
+    sprintf(buf, "variant: %.20s rays: %d/%d (%dx%d) cast: %luus walls: %luus "
+            "spans: %luus sprites: %luus present: %luus", profile->variant,
+            profile->rays_cast, profile->rays, profile->width, profile->height,
+            profile->us[PROFILE_RAYS], profile->us[PROFILE_WALLS],
+            profile->us[PROFILE_SPANS], profile->us[PROFILE_SPRITES],
+            profile->us[PROFILE_PRESENT]);
+    len = strlen(buf);
+    if(!profile->worker_num || len+9+6 >= PROFILE_TEXT_MAX) return;
+    strcpy(buf+len, " workers:");
+    len += 9;
+    /* Show as many workers as the buffer can hold. */
+    for(i=0;i<profile->worker_num && len+6 < PROFILE_TEXT_MAX;i++){
+        len += sprintf(buf+len, " %lu%%", profile->worker_busy[i] > 999 ?
+                       999 : profile->worker_busy[i]);
+    }
+}
+
+#if PERFCOUNT
+void profile_format_events(Profile *profile, int stage, int average,
+                           char *buf) {
+    int e;
+    unsigned long value;
+    size_t len;
+    len = sprintf(buf, "%s:", _profile_stages[stage]);
+    if(!profile->counters || !profile->counters->num){
+        strcpy(buf+len, " no counters");
+        return;
+    }
+    for(e=0;e<PERF_EVENTS;e++){
+        if(profile->counters->fds[e] < 0) continue;
+        if(average){
+            value = profile->frames ? profile->events_total[stage][e]/
+                                      profile->frames : 0;
+        }else{
+            value = profile->events_last[stage][e];
+        }
+        len += sprintf(buf+len, " %s: %lu", perfcount_name(e), value);
+    }
+}
+#endif
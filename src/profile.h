@@ -0,0 +1,135 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <config.h>
+
+#if PERFCOUNT
+#include <perfcount.h>
+#endif
+
+/* The size of the buffer passed to profile_format. */
+#define PROFILE_TEXT_MAX 256
+
+/* The maximum number of workers whose utilization is kept. */
+#define PROFILE_WORKERS 16
+
+/* The stages of a frame that are timed. */
+enum {
+    PROFILE_RAYS,
+    PROFILE_WALLS,
+    PROFILE_SPANS,
+    PROFILE_SPRITES,
+    /* Timed by the caller around the presentation of the frame, it is added
+     * to the next frame. */
+    PROFILE_PRESENT,
+    PROFILE_STAGES
+};
+
+typedef struct {
+    /* The name of the wall pass variant used for the last frame. */
+    const char *variant;
+    /* The resolution of the last frame. */
+    int rays;
+    int width;
+    int height;
+    /* The number of rays actually cast during the last frame. */
+    int rays_cast;
+    /* Time spent in each stage in microseconds, averaged over the last
+     * frames. The time of all the workers is added up when the frame is
+     * shared between several. */
+    unsigned long us[PROFILE_STAGES];
+    /* Time spent in each stage during the current frame, as a stage may be
+     * timed several times per frame. */
+    unsigned long frame[PROFILE_STAGES];
+    unsigned long start[PROFILE_STAGES];
+    /* The number of workers that shared the frame, 0 if it was rendered by a
+     * single thread, and the share of the frame that each of them spent
+     * working in percent, averaged over the last frames. */
+    int worker_num;
+    unsigned long worker_busy[PROFILE_WORKERS];
+#if PERFCOUNT
+    /* The counters read at the start and the end of each stage, NULL (the
+     * default) to only time them. They count the thread that opened them,
+     * so the strips drawn by the other workers of a job system are not
+     * counted. */
+    PerfCounters *counters;
+    /* The events of each stage during the current frame, the last frame and
+     * all the frames since the counters were set. */
+    unsigned long events[PROFILE_STAGES][PERF_EVENTS];
+    unsigned long events_last[PROFILE_STAGES][PERF_EVENTS];
+    unsigned long events_total[PROFILE_STAGES][PERF_EVENTS];
+    unsigned long events_start[PROFILE_STAGES][PERF_EVENTS];
+    unsigned long frames; /* The frames in events_total. */
+#endif
+} Profile;
+
+void profile_init(Profile *profile);
+
+/* Reset the per-frame counters. */
+void profile_begin_frame(Profile *profile);
+
+/* Add the time spent in each stage during the frame to the averages. */
+void profile_end_frame(Profile *profile);
+
+/* now is the current time in microseconds. */
+void profile_start(Profile *profile, int stage, unsigned long now);
+
+void profile_stop(Profile *profile, int stage, unsigned long now);
+
+/* Add the time spent in each stage but PROFILE_PRESENT and the rays cast
+ * during the current frame of other to the current frame of profile. */
+void profile_merge(Profile *profile, Profile *other);
+
+/* Add the utilization of n workers to the averages, busy being the time each
+ * one spent working during the us microseconds of the frame. */
+void profile_workers(Profile *profile, int n, const unsigned long *busy,
+                     unsigned long us);
+
+/* Write a single line describing the last frame into buf (which should be at
+ * least PROFILE_TEXT_MAX bytes long).
+ */
+void profile_format(Profile *profile, char *buf);
+
+#if PERFCOUNT
+/* Write the events of a stage into buf (which should be at least
+ * PROFILE_TEXT_MAX bytes long), for the last frame or averaged over all the
+ * frames if average isn't 0. */
+void profile_format_events(Profile *profile, int stage, int average,
+                           char *buf);
+#endif
+
+#endif
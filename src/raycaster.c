@@ -35,14 +35,34 @@
 #include <raycaster.h>
 
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 
-#define RENDERER r->renderer
+#define RENDERER (*r->target)
+
+#if JOBS
+/* A strip drawn by a job. */
+typedef struct {
+    Raycaster *r;
+    int pass; /* The index of the wall pass in _wall_passes. */
+    int x1, x2;
+    /* The copy of r used by each worker, so that it has its own stats and
+     * arena. NULL until the first job of the worker. */
+    Raycaster **views;
+} StripJob;
+#endif
 
 void raycaster_init(Raycaster *r, int width, int height, char *title,
                     Map *map, fixed_t x, fixed_t y, fixed_t a,
                     fixed_t *zbuffer) {
+    render_init(&r->renderer, width, height, title);
+    raycaster_init_target(r, &r->renderer, map, x, y, a, zbuffer);
+}
+
+void raycaster_init_target(Raycaster *r, Renderer *target, Map *map,
+                           fixed_t x, fixed_t y, fixed_t a, fixed_t *zbuffer) {
     linit();
-    render_init(&RENDERER, width, height, title);
+    r->target = target;
     r->width = render_get_width(&RENDERER);
     r->height = render_get_height(&RENDERER);
     /* Settings */
@@ -53,216 +73,1087 @@ void raycaster_init(Raycaster *r, int width, int height, char *title,
     r->len = 25;
     r->speed = 5;
     r->rotspeed = 100;
+    r->target_ms = 0;
+    r->strip_width = STRIP_WIDTH;
+    r->minimap = 0;
     /* Features */
     r->texture = 1;
     r->fisheye_fix = 1;
+    r->floor = 1;
+    r->detail = 0;
+    r->adaptive = 0;
+    r->incremental = 0;
+    r->reuse_rays = 0;
     /* Data */
+    r->columns = malloc(r->width*sizeof(Column));
+    r->wall_h = malloc(r->width*sizeof(int));
+    r->span_dirs = malloc((r->width/SPAN_STEP+2)*sizeof(Vector2));
+    r->depth_min = malloc((r->width/DEPTH_TILE+1)*sizeof(fixed_t));
+    r->depth_max = malloc((r->width/DEPTH_TILE+1)*sizeof(fixed_t));
+    r->dirty = malloc(r->width);
+    r->ray_cache.columns = malloc(r->width*sizeof(Column));
+    r->ray_cache.keys = malloc(r->width*sizeof(long));
+    if(!r->columns || !r->wall_h || !r->span_dirs || !r->depth_min ||
+       !r->depth_max || !r->dirty || !r->ray_cache.columns ||
+       !r->ray_cache.keys){
+        fputs("[raycaster] Failed to allocate the column buffers!", stderr);
+        exit(-1);
+    }
     r->map = map;
     r->map_width = map->width;
     r->map_height = map->height;
     r->zbuffer = zbuffer;
+    r->gbuffer = NULL;
     r->sprite_num = map->sprite_num;
     r->sprites = map->sprites;
+    r->sprite_views = NULL;
+    r->sprite_view_num = 0;
+    r->sprite_view_max = 0;
     /* View */
     r->x = x;
     r->y = y;
     r->r = a;
+    /* Dynamic resolution */
+    r->frame_us = 0;
+    r->adapt_wait = 0;
+    r->map_layer.pixels = NULL;
+    r->map_layer.width = 0;
+    r->map_layer.height = 0;
+    r->map_layer.map = NULL;
+    /* Rotation reuse */
+    r->ray_cache.x = 0;
+    r->ray_cache.y = 0;
+    r->ray_cache.fov = 0;
+    r->ray_cache.rays = 0;
+    r->ray_cache.len = 0;
+    r->ray_cache.map = NULL;
+    r->ray_cache.map_revision = 0;
+    /* Incremental rendering */
+    r->last.valid = 0;
+    r->last.sprites = NULL;
+    r->last.sprite_num = 0;
+    r->last.sprite_max = 0;
+    r->arenas = malloc(sizeof(Arena));
+    if(!r->arenas){
+        fputs("[raycaster] Failed to allocate the arena!", stderr);
+        exit(-1);
+    }
+    arena_init(r->arenas, 0);
+    r->arena_num = 1;
+    r->worker = 0;
+#if JOBS
+    r->jobs = NULL;
+#endif
+    /* Stats */
+    profile_init(&r->profile);
+}
+
+void raycaster_free(Raycaster *r) {
+    int i;
+    free(r->columns);
+    free(r->wall_h);
+    free(r->span_dirs);
+    free(r->depth_min);
+    free(r->depth_max);
+    free(r->dirty);
+    free(r->ray_cache.columns);
+    free(r->ray_cache.keys);
+    free(r->map_layer.pixels);
+    free(r->last.sprites);
+    free(r->sprite_views);
+    r->columns = NULL;
+    r->wall_h = NULL;
+    r->span_dirs = NULL;
+    r->depth_min = NULL;
+    r->depth_max = NULL;
+    r->dirty = NULL;
+    r->ray_cache.columns = NULL;
+    r->ray_cache.keys = NULL;
+    r->ray_cache.rays = 0;
+    r->map_layer.pixels = NULL;
+    r->map_layer.width = 0;
+    r->map_layer.height = 0;
+    r->map_layer.map = NULL;
+    r->last.sprites = NULL;
+    r->last.sprite_max = 0;
+    r->last.valid = 0;
+    r->sprite_views = NULL;
+    r->sprite_view_num = 0;
+    r->sprite_view_max = 0;
+    for(i=0;i<r->arena_num;i++) arena_free(r->arenas+i);
+    free(r->arenas);
+    r->arenas = NULL;
+    r->arena_num = 0;
 }
 
 void raycaster_set_sprites(Raycaster *r, Sprite *sprites, int sprite_num) {
     r->sprites = sprites;
     r->sprite_num = sprite_num;
+    r->sprite_view_num = 0;
+    r->last.valid = 0;
+}
+
+void raycaster_set_map(Raycaster *r, Map *map) {
+    r->map = map;
+    r->map_width = map->width;
+    r->map_height = map->height;
+    raycaster_set_sprites(r, map->sprites, map->sprite_num);
 }
 
 Texture *_get_tile_tex(Raycaster *r, int cx, int cy) {
     if(cx >= 0 && cx < r->map_width && cy >= 0 && cy < r->map_height){
-        return r->map->tileset[r->map->data[cy*r->map_width+cx]-1].texture;
+        return r->map->tileset[MAP_TILE(r->map, cx, cy)-1].texture;
     }
     return r->map->tileset[0].texture;
 }
 
-void raycaster_render_map(Raycaster *r) {
-    int x, y;
-    fixed_t i;
-    RayEnd end;
-    render_clear(&RENDERER, 0);
-    for(y=0;y<r->map_height;y++){
-        for(x=0;x<r->map_width;x++){
-            if(r->map->data[y*r->map_width+x]){
-                render_rect(&RENDERER, x*r->scale, y*r->scale, r->scale,
-                            r->scale, 0, 0, 0);
-            }
+int _raycaster_sort_sprites(const void *item1, const void *item2) {
+    const SpriteView *sprite1 = item1;
+    const SpriteView *sprite2 = item2;
+    if(sprite1->dist < sprite2->dist) return 1;
+    if(sprite1->dist == sprite2->dist) return 0;
+    else return -1;
+}
+
+/* Compute the ray n from the face hit by the ray of ref, knowing that it hits
+ * the same face. Returns 0 if it could not be computed. */
+int _interpolate_column(Raycaster *r, int n, Column *ref) {
+    fixed_t a = r->ray_base+n*(TO_FIXED(r->fov)/r->rays);
+    fixed_t c = DCOS(a);
+    fixed_t s = DSIN(a);
+    fixed_t hit;
+    fixed_t len;
+    Column *col = r->columns+n;
+    /* Intersect the ray with the line of the face: when a ray going up or
+     * left hits a cell, it hits its bottom or right side. */
+    if(ref->end.x_axis_hit){
+        if(!s) return 0;
+        len = DIV(TO_FIXED(ref->end.cy+(s < 0))-r->y, s);
+        hit = r->x+MUL(c, len);
+    }else{
+        if(!c) return 0;
+        len = DIV(TO_FIXED(ref->end.cx+(c < 0))-r->x, c);
+        hit = r->y+MUL(s, len);
+    }
+    col->end = ref->end;
+    col->end.len = len;
+    col->u = hit-FLOOR(hit);
+    return 1;
+}
+
+/* The face of the cell hit by a ray cast from the cell cx, cy. */
+char _hit_face(RayEnd *end, int cx, int cy) {
+    if(!end->hit) return FACE_NONE;
+    /* x_axis_hit is set when the ray crossed a horizontal edge of the grid,
+     * the hit cell is then above or below the start cell. */
+    if(end->x_axis_hit) return end->cy > cy ? FACE_NORTH : FACE_SOUTH;
+    return end->cx > cx ? FACE_WEST : FACE_EAST;
+}
+
+/* Cast the ray n of the wall pass. */
+void _cast_column(Raycaster *r, int n) {
+    fixed_t a = r->ray_base+n*(TO_FIXED(r->fov)/r->rays);
+    fixed_t hit;
+    Column *col = r->columns+n;
+    long k = r->ray_k+n;
+    if(r->reuse_rays && r->ray_cache.keys[k%r->rays] == k){
+        *col = r->ray_cache.columns[k%r->rays];
+        return;
+    }
+    col->end = raycaster_raycast(r, r->x, r->y, r->x+DCOS(a)*r->len,
+                                 r->y+DSIN(a)*r->len);
+    if(col->end.x_axis_hit){
+        hit = r->x+MUL(DCOS(a), col->end.len);
+    }else{
+        hit = r->y+MUL(DSIN(a), col->end.len);
+    }
+    col->u = hit-FLOOR(hit);
+    r->profile.rays_cast++;
+    /* The distance found by raycaster_raycast is less precise than the one
+     * computed from the face, use the latter so that the cast and computed
+     * rays match. */
+    if(r->adaptive && col->end.hit) _interpolate_column(r, n, col);
+}
+
+/* Fill the rays between n1 and n2 (both already cast). When both rays hit the
+ * same face of the same cell, every ray in between hits it too (nothing can
+ * hide a part of a face narrower than a cell without hiding one of its ends)
+ * and the rays are computed directly. Otherwise the range is split in two. */
+void _subdivide_columns(Raycaster *r, int n1, int n2) {
+    int n;
+    int mid;
+    RayEnd *e1 = &r->columns[n1].end;
+    RayEnd *e2 = &r->columns[n2].end;
+    if(n2-n1 < 2) return;
+    if(e1->hit && e2->hit && e1->cx == e2->cx && e1->cy == e2->cy &&
+       e1->x_axis_hit == e2->x_axis_hit){
+        for(n=n1+1;n<n2;n++){
+            if(!_interpolate_column(r, n, r->columns+n1)) _cast_column(r, n);
         }
+        return;
     }
-    for(i=-(TO_FIXED(r->fov)/2);i<TO_FIXED(r->fov)/2;
-        i+=TO_FIXED(r->fov)/r->rays){
-        end = raycaster_raycast(r, r->x, r->y, r->x+DCOS(r->r+i)*r->len,
-                                r->y+DSIN(r->r+i)*r->len);
-        if(r->fisheye_fix) end.len = MUL(end.len, DCOS(i));
-        render_line(&RENDERER, TO_INT(r->x*r->scale), TO_INT(r->y*r->scale),
-                    TO_INT((r->x+MUL(DCOS(r->r+i), end.len))*r->scale),
-                    TO_INT((r->y+MUL(DSIN(r->r+i), end.len))*r->scale), 0, 255,
-                    0);
+    mid = (n1+n2)/2;
+    _cast_column(r, mid);
+    _subdivide_columns(r, n1, mid);
+    _subdivide_columns(r, mid, n2);
+}
+
+/* Cast the rays n1 to n2 (excluded) of the wall pass. */
+void _cast_columns(Raycaster *r, int n1, int n2) {
+    int n;
+    int last;
+    long k;
+    if(!r->adaptive){
+        for(n=n1;n<n2;n++) _cast_column(r, n);
+    }else if(n1 < n2){
+        _cast_column(r, n1);
+        for(n=n1;n<n2-1;n=last){
+            last = n+ADAPTIVE_STEP;
+            if(last > n2-1) last = n2-1;
+            _cast_column(r, last);
+            _subdivide_columns(r, n, last);
+        }
     }
-    for(x=0;x<r->sprite_num;x++){
-        render_set_pixel(&RENDERER, TO_INT(r->sprites[x].x*r->scale),
-                         TO_INT(r->sprites[x].y*r->scale), 0, 0, 255);
+    if(r->reuse_rays){
+        /* The rays of the frame are rays consecutive k, so they never share
+         * an entry. */
+        for(n=n1,k=r->ray_k+n1;n<n2;n++,k++){
+            r->ray_cache.columns[k%r->rays] = r->columns[n];
+            r->ray_cache.keys[k%r->rays] = k;
+        }
     }
-    render_line(&RENDERER, TO_INT(r->x*r->scale), TO_INT(r->y*r->scale),
-                TO_INT((r->x+DCOS(r->r))*r->scale),
-                TO_INT((r->y+DSIN(r->r))*r->scale), 255, 0, 0);
 }
 
-int _raycaster_sort_sprites(const void *item1, const void *item2) {
-    Sprite *sprite1 = (Sprite*)item1;
-    Sprite *sprite2 = (Sprite*)item2;
-    if(sprite1->dist < sprite2->dist) return 1;
-    if(sprite1->dist == sprite2->dist) return 0;
-    else return -1;
+/* Prefetch the chunks around the camera and in front of it when the map is
+ * streamed. */
+void _update_chunks(Raycaster *r) {
+#if CHUNKMAP
+    if(r->map->data) return;
+    chunkmap_update(r->map->chunks, TO_INT(r->x), TO_INT(r->y),
+                    TO_INT(r->x+DCOS(r->r)*r->len),
+                    TO_INT(r->y+DSIN(r->r)*r->len), r->len);
+#else
+    (void)r;
+#endif
 }
 
-void raycaster_render_world(Raycaster *r) {
+/* Find the angle of the rays of the frame, and empty the ray cache if the
+ * rays it contains can't be reused. */
+void _setup_rays(Raycaster *r) {
+    int n;
+    fixed_t inc = TO_FIXED(r->fov)/r->rays;
+    RayCache *cache = &r->ray_cache;
+    r->ray_base = r->r-TO_FIXED(r->fov)/2;
+    if(!r->reuse_rays) return;
+    /* Snap the rays to multiples of inc, so that a ray keeps the same angle
+     * when the camera turns. r->r is between 0 and 360 degrees. */
+    r->ray_k = (r->ray_base+TO_FIXED(360))/inc;
+    r->ray_base = r->ray_k*inc-TO_FIXED(360);
+    if(cache->x != r->x || cache->y != r->y || cache->fov != r->fov ||
+       cache->rays != r->rays || cache->len != r->len ||
+       cache->map != r->map || cache->map_revision != r->map->revision){
+        for(n=0;n<r->rays;n++) cache->keys[n] = -1;
+        cache->x = r->x;
+        cache->y = r->y;
+        cache->fov = r->fov;
+        cache->rays = r->rays;
+        cache->len = r->len;
+        cache->map = r->map;
+        cache->map_revision = r->map->revision;
+    }
+}
+
+/* Generate a wall pass for each combination of features. */
+#define WORLD_FUNC _render_walls_flat
+#define WORLD_TEXTURE 0
+#define WORLD_FISHEYE 0
+#define WORLD_WIDE 0
+#include <world.h>
+
+#define WORLD_FUNC _render_walls_flat_fisheye
+#define WORLD_TEXTURE 0
+#define WORLD_FISHEYE 1
+#define WORLD_WIDE 0
+#include <world.h>
+
+#define WORLD_FUNC _render_walls_tex
+#define WORLD_TEXTURE 1
+#define WORLD_FISHEYE 0
+#define WORLD_WIDE 0
+#include <world.h>
+
+#define WORLD_FUNC _render_walls_tex_fisheye
+#define WORLD_TEXTURE 1
+#define WORLD_FISHEYE 1
+#define WORLD_WIDE 0
+#include <world.h>
+
+#define WORLD_FUNC _render_walls_flat_wide
+#define WORLD_TEXTURE 0
+#define WORLD_FISHEYE 0
+#define WORLD_WIDE 1
+#include <world.h>
+
+#define WORLD_FUNC _render_walls_flat_fisheye_wide
+#define WORLD_TEXTURE 0
+#define WORLD_FISHEYE 1
+#define WORLD_WIDE 1
+#include <world.h>
+
+#define WORLD_FUNC _render_walls_tex_wide
+#define WORLD_TEXTURE 1
+#define WORLD_FISHEYE 0
+#define WORLD_WIDE 1
+#include <world.h>
+
+#define WORLD_FUNC _render_walls_tex_fisheye_wide
+#define WORLD_TEXTURE 1
+#define WORLD_FISHEYE 1
+#define WORLD_WIDE 1
+#include <world.h>
+
+typedef struct {
+    void (*render)(Raycaster *r, int x1, int x2);
+    const char *name;
+} WallPass;
+
+/* Indexed by texture | fisheye_fix<<1 | (rays < width)<<2. */
+const WallPass _wall_passes[8] = {
+    {_render_walls_flat, "flat"},
+    {_render_walls_tex, "tex"},
+    {_render_walls_flat_fisheye, "flat+fisheye"},
+    {_render_walls_tex_fisheye, "tex+fisheye"},
+    {_render_walls_flat_wide, "flat+wide"},
+    {_render_walls_tex_wide, "tex+wide"},
+    {_render_walls_flat_fisheye_wide, "flat+fisheye+wide"},
+    {_render_walls_tex_fisheye_wide, "tex+fisheye+wide"}
+};
+
+/* The greatest common divisor of a and b. */
+int _gcd(int a, int b) {
+    int t;
+    while(b){
+        t = a%b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* Compute the direction of the ray at the start of each span for the current
+ * frame. With the fisheye fix it is divided by the cosine of the ray angle, to
+ * get the position on the floor by multiplying it by the distance to the
+ * camera plane. */
+void _setup_spans(Raycaster *r) {
+    int k;
+    int x;
     fixed_t i;
+    fixed_t c;
+    Vector2 *dir = r->span_dirs;
+    for(k=0,x=0;x<=r->width+SPAN_STEP;k++,x+=SPAN_STEP){
+        i = -(TO_FIXED(r->fov)/2)+TO_FIXED(r->fov)*x/r->width;
+        dir[k].x = DCOS(r->r+i);
+        dir[k].y = DSIN(r->r+i);
+        if(r->fisheye_fix){
+            c = DCOS(i);
+            dir[k].x = DIV(dir[k].x, c);
+            dir[k].y = DIV(dir[k].y, c);
+        }
+    }
+}
+
+/* Draw the floor and the ceiling between the columns x1 and x2 (excluded),
+ * where the walls drawn by the wall pass leave them visible. Each row is at a
+ * single distance from the camera plane. */
+void _render_floor(Raycaster *r, int x1, int x2) {
     int p;
-    int c;
-    int h;
-    Sprite *sprite;
+    int k;
+    int x, start, end;
+    int seg_start, seg_end;
+    fixed_t d;
+    Vector2 *dir = r->span_dirs;
+    Span floor;
+    Span ceiling;
+    floor.layer = r->map->floor;
+    ceiling.layer = r->map->ceiling;
+    floor.tileset = ceiling.tileset = r->map->tileset;
+    floor.map_width = ceiling.map_width = r->map_width;
+    floor.map_height = ceiling.map_height = r->map_height;
+    for(p=1;p<r->height/2;p++){
+        d = TO_FIXED(r->height)/(2*p);
+        if(d >= TO_FIXED(r->len)) continue;
+        floor.fog = ceiling.fog = 255-TO_INT(d/r->len*255);
+        for(k=x1/SPAN_STEP,x=k*SPAN_STEP;x<x2;k++,x+=SPAN_STEP){
+            seg_start = x < x1 ? x1 : x;
+            seg_end = x+SPAN_STEP;
+            if(seg_end > x2) seg_end = x2;
+            floor.dx = ceiling.dx = MUL(dir[k+1].x-dir[k].x, d)/SPAN_STEP;
+            floor.dy = ceiling.dy = MUL(dir[k+1].y-dir[k].y, d)/SPAN_STEP;
+            /* Only draw the parts of the row that are not behind a wall. */
+            for(end=seg_start;end<seg_end;){
+                while(end < seg_end && r->wall_h[end] > p) end++;
+                start = end;
+                while(end < seg_end && r->wall_h[end] <= p) end++;
+                if(start == end) continue;
+                floor.x = ceiling.x = r->x+MUL(dir[k].x, d)+
+                                      floor.dx*(start-x);
+                floor.y = ceiling.y = r->y+MUL(dir[k].y, d)+
+                                      floor.dy*(start-x);
+                if(floor.layer){
+                    render_hspan(&RENDERER, &floor, start, end,
+                                 r->height/2+p);
+                }
+                if(ceiling.layer){
+                    render_hspan(&RENDERER, &ceiling, start, end,
+                                 r->height/2-1-p);
+                }
+            }
+        }
+    }
+}
+
+/* Sort r->sprite_views with _raycaster_sort_sprites. This is a stable merge
+ * sort like the qsort of glibc, with a buffer from the arena instead of the
+ * heap. */
+void _sort_sprites(Raycaster *r) {
+    int n = r->sprite_num;
+    int width;
+    int i, k;
+    int a, a_end;
+    int b, b_end;
+    SpriteView *src = r->sprite_views;
+    SpriteView *dst = arena_alloc(r->arenas+r->worker, n*sizeof(SpriteView));
+    SpriteView *tmp;
+    for(width=1;width<n;width*=2){
+        for(i=0;i<n;i+=2*width){
+            a = k = i;
+            a_end = b = i+width < n ? i+width : n;
+            b_end = i+2*width < n ? i+2*width : n;
+            while(a < a_end && b < b_end){
+                if(_raycaster_sort_sprites(src+b, src+a) < 0){
+                    dst[k++] = src[b++];
+                }else{
+                    dst[k++] = src[a++];
+                }
+            }
+            while(a < a_end) dst[k++] = src[a++];
+            while(b < b_end) dst[k++] = src[b++];
+        }
+        tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    if(src != r->sprite_views){
+        memcpy(r->sprite_views, src, n*sizeof(SpriteView));
+    }
+}
+
+/* Sort the sprites and find their position and size on screen. */
+void _project_sprites(Raycaster *r) {
+    int p;
+    SpriteView *views;
+    SpriteView *sprite;
     fixed_t a;
     fixed_t tmp;
-    int x;
+    if(r->sprite_num > r->sprite_view_max){
+        views = realloc(r->sprite_views, r->sprite_num*sizeof(SpriteView));
+        if(!views){
+            fputs("[raycaster] Failed to allocate the sprite views!", stderr);
+            exit(-1);
+        }
+        r->sprite_views = views;
+        r->sprite_view_max = r->sprite_num;
+    }
+    /* Keep the order of the last frame, which is often still sorted. */
+    if(r->sprite_view_num != r->sprite_num){
+        for(p=0;p<r->sprite_num;p++) r->sprite_views[p].index = p;
+        r->sprite_view_num = r->sprite_num;
+    }
+    for(p=0;p<r->sprite_num;p++){
+        sprite = r->sprite_views+p;
+        sprite->x = r->sprites[sprite->index].x;
+        sprite->y = r->sprites[sprite->index].y;
+        sprite->texture = r->sprites[sprite->index].texture;
+        sprite->visible = r->sprites[sprite->index].visible;
+        sprite->dist = SQRT(MUL(r->x-sprite->x, r->x-sprite->x)+
+                            MUL(r->y-sprite->y, r->y-sprite->y));
+    }
+    if(r->sprite_num > 1) _sort_sprites(r);
+    for(p=0;p<r->sprite_num;p++){
+        sprite = r->sprite_views+p;
+        sprite->screen_x = -1;
+        sprite->h = 0;
+        if(sprite->dist > TO_FIXED(r->len) || !sprite->visible) continue;
+        /* Calculate the position of the sprite on screen. */
+        a = datan2(sprite->y-r->y, sprite->x-r->x);
+        if(a < 0) a += TO_FIXED(360);
+        tmp = r->r+TO_FIXED(r->fov)/2-a;
+        if(a > TO_FIXED(270) && r->r < TO_FIXED(90)) tmp += TO_FIXED(360);
+        if(r->r > TO_FIXED(270) && a < TO_FIXED(90)) tmp -= TO_FIXED(360);
+        sprite->screen_x = r->width-TO_INT(tmp/r->fov*r->width);
+        /* The height without clipping. */
+        sprite->h = TO_INT(DIV(TO_FIXED(r->height),
+                               (sprite->dist ? sprite->dist : 1)));
+    }
+}
+
+/* Update the depth tiles that contain the columns x1 to x2 (excluded) from the
+ * z-buffer. */
+void _update_depth_tiles(Raycaster *r, int x1, int x2) {
+    int k;
+    int x, end;
+    fixed_t min, max;
+    for(k=x1/DEPTH_TILE;k*DEPTH_TILE<x2;k++){
+        x = k*DEPTH_TILE;
+        end = x+DEPTH_TILE > r->width ? r->width : x+DEPTH_TILE;
+        min = max = r->zbuffer[x];
+        for(;x<end;x++){
+            if(r->zbuffer[x] < min) min = r->zbuffer[x];
+            if(r->zbuffer[x] > max) max = r->zbuffer[x];
+        }
+        r->depth_min[k] = min;
+        r->depth_max[k] = max;
+    }
+}
+
+/* Draw the column x of sprite, with the column l of its texture. h is its
+ * height after clipping. */
+void _draw_sprite_column(Raycaster *r, SpriteView *sprite, int h, int x,
+                         int l) {
+    GBuffer *g = r->gbuffer;
+    if(!g || !g->no_color){
+        render_texvline(&RENDERER, sprite->texture, r->height/2-h/2,
+                        r->height/2+h/2, r->height/2-sprite->h/2,
+                        r->height/2+sprite->h/2, x, l,
+                        255-TO_INT(sprite->dist/r->len*255));
+    }
+    if(g && g->sprite){
+        render_texvline_label(&RENDERER, sprite->texture, r->height/2-h/2,
+                              r->height/2+h/2, r->height/2-sprite->h/2,
+                              r->height/2+sprite->h/2, x, l, g->sprite,
+                              sprite->index+1);
+    }
+}
+
+/* Draw the parts of the projected sprites that are between the columns x1 and
+ * x2 (excluded), from the farthest to the nearest. */
+void _render_sprites(Raycaster *r, int x1, int x2) {
+    int p;
+    int h;
+    int i;
+    int k;
+    int start, end;
+    int tile_start, tile_end;
     fixed_t inc;
-    fixed_t l;
-    int no_clip_h;
-    int t;
-    RayEnd end;
-    Texture *tex;
-    while(r->r < 0) r->r += TO_FIXED(360);
-    while(r->r > TO_FIXED(360)) r->r -= TO_FIXED(360);
-#if !NOCLEAR
-    render_clear(&RENDERER, 1);
-#endif
-    for(i=-(TO_FIXED(r->fov)/2),p=0;i<TO_FIXED(r->fov)/2;
-        i+=TO_FIXED(r->fov)/r->rays, p+=r->width/r->rays){
-        end = raycaster_raycast(r, r->x, r->y, r->x+DCOS(r->r+i)*r->len,
-                                r->y+DSIN(r->r+i)*r->len);
-        r->zbuffer[p] = end.len;
-        if(!end.hit){
-            for(c=0;c<r->width/r->rays;c++){
-                render_vline(&RENDERER, 0, r->height, p+c, 0, 0, 0);
+    SpriteView *sprite;
+    for(p=0;p<r->sprite_num;p++){
+        sprite = r->sprite_views+p;
+        if(sprite->h <= 0) continue;
+        start = sprite->screen_x-sprite->h/2;
+        end = sprite->screen_x+sprite->h/2;
+        if(end <= x1 || start >= x2) continue;
+        h = sprite->h > r->height ? r->height : sprite->h;
+        inc = TO_FIXED(TEX_WIDTH(sprite->texture))/sprite->h;
+        tile_start = start < x1 ? x1 : start;
+        tile_end = end > x2 ? x2 : end;
+        for(k=tile_start/DEPTH_TILE;k*DEPTH_TILE<tile_end;k++){
+            /* Skip the tiles where the sprite is behind all the walls. */
+            if(r->depth_max[k] <= sprite->dist) continue;
+            i = k*DEPTH_TILE < tile_start ? tile_start : k*DEPTH_TILE;
+            end = (k+1)*DEPTH_TILE > tile_end ? tile_end : (k+1)*DEPTH_TILE;
+            /* The depth test is only needed if a wall may be in front of the
+             * sprite. */
+            if(r->depth_min[k] > sprite->dist){
+                for(;i<end;i++){
+                    _draw_sprite_column(r, sprite, h, i,
+                                        TO_INT((i-start)*inc));
+                }
+                continue;
+            }
+            for(;i<end;i++){
+                if(r->zbuffer[i] > sprite->dist){
+                    _draw_sprite_column(r, sprite, h, i,
+                                        TO_INT((i-start)*inc));
+                }
             }
-            continue;
         }
-        tex = _get_tile_tex(r, end.cx, end.cy);
-        if(end.x_axis_hit){
-            l = r->x+MUL(DCOS(r->r+i), end.len);
-            l = l-FLOOR(l);
-            l *= TEX_WIDTH(tex);
-        }else{
-            l = r->y+MUL(DSIN(r->r+i), end.len);
-            l = l-FLOOR(l);
-            l *= TEX_WIDTH(tex);
+    }
+}
+
+/* Fill the planes of r->gbuffer between the columns x1 and x2 (excluded), and
+ * the z-buffer if the wall pass doesn't run. */
+void _fill_gbuffer(Raycaster *r, int x1, int x2) {
+    int x, y;
+    int n;
+    int step = r->width/r->rays;
+    int stride = render_get_width(&RENDERER);
+    int cx = TO_INT(r->x);
+    int cy = TO_INT(r->y);
+    GBuffer *g = r->gbuffer;
+    Column *col;
+    for(x=x1;x<x2;x++){
+        n = x/step;
+        if(n >= r->rays) n = r->rays-1;
+        col = r->columns+n;
+        if(g->no_color) r->zbuffer[x] = col->end.len;
+        if(g->tile){
+            g->tile[x] = col->end.hit ? MAP_TILE(r->map, col->end.cx,
+                                                 col->end.cy) : 0;
         }
-        if(r->fisheye_fix) end.len = MUL(end.len, DCOS(i));
-        h = TO_INT(DIV(TO_FIXED(r->height), (end.len ? end.len : 1)));
-        no_clip_h = h;
-        if(h > r->height) h = r->height;
-        for(c=0;c<r->width/r->rays;c++){
-#if NOCLEAR
-            render_vline(&RENDERER, 0, r->height/2-h/2, p+c, 0, 0, 0);
-            render_vline(&RENDERER, r->height/2+h/2, r->height, p+c, 0,
-                         0, 0);
+        if(g->face) g->face[x] = _hit_face(&col->end, cx, cy);
+        if(g->u) g->u[x] = col->u;
+    }
+    /* The sprite pass only sets the pixels where a sprite is drawn. */
+    if(g->sprite){
+        for(y=0;y<r->height;y++){
+            memset(g->sprite+y*stride+x1, 0,
+                   (x2-x1)*sizeof(unsigned short));
+        }
+    }
+}
+
+/* Draw everything between the columns x1 and x2 (excluded) from the rays
+ * stored in r->columns. The z-buffer should be up to date around this range,
+ * as the depth tiles are updated entirely. */
+void _draw_columns(Raycaster *r, const WallPass *pass, int x1, int x2) {
+    char color = !r->gbuffer || !r->gbuffer->no_color;
+#if !NOCLEAR
+    if(color) render_rect(&RENDERER, x1, 0, x2-x1, r->height, 0, 0, 0);
 #endif
-            if(r->texture){
-                render_texvline(&RENDERER, tex, r->height/2-h/2,
-                                r->height/2+h/2, r->height/2-no_clip_h/2,
-                                r->height/2+no_clip_h/2, p+c, TO_INT(l),
-                                255-TO_INT(end.len/r->len*255));
-            }else{
-                render_vline(&RENDERER, r->height/2-h/2,
-                             r->height/2+h/2, p+c,
-                             (255-TO_INT(end.len/r->len*255))*(!end.x_axis_hit),
-                             (255-TO_INT(end.len/r->len*255))*end.x_axis_hit,
-                             0);
-            }
+    profile_start(&r->profile, PROFILE_WALLS, render_us(&RENDERER));
+    if(color) pass->render(r, x1, x2);
+    if(r->gbuffer) _fill_gbuffer(r, x1, x2);
+    _update_depth_tiles(r, x1, x2);
+    profile_stop(&r->profile, PROFILE_WALLS, render_us(&RENDERER));
+    if(color && r->floor && (r->map->floor || r->map->ceiling)){
+        profile_start(&r->profile, PROFILE_SPANS, render_us(&RENDERER));
+        _render_floor(r, x1, x2);
+        profile_stop(&r->profile, PROFILE_SPANS, render_us(&RENDERER));
+    }
+    if(r->sprite_num > 0){
+        profile_start(&r->profile, PROFILE_SPRITES, render_us(&RENDERER));
+        _render_sprites(r, x1, x2);
+        profile_stop(&r->profile, PROFILE_SPRITES, render_us(&RENDERER));
+    }
+}
+
+/* Cast the rays and draw everything between the columns x1 and x2 (excluded).
+ * x1 and x2 should be at the start of a ray and of a depth tile. */
+void _render_strip(Raycaster *r, const WallPass *pass, int x1, int x2) {
+    int step = r->width/r->rays;
+    int n2 = x2/step;
+    if(x2 >= r->width || n2 > r->rays) n2 = r->rays;
+    profile_start(&r->profile, PROFILE_RAYS, render_us(&RENDERER));
+    _cast_columns(r, x1/step, n2);
+    profile_stop(&r->profile, PROFILE_RAYS, render_us(&RENDERER));
+    _draw_columns(r, pass, x1, x2);
+}
+
+#if JOBS
+void _strip_job(void *data, int worker) {
+    StripJob *strip = data;
+    Raycaster *view = strip->views[worker];
+    if(!view){
+        view = arena_alloc(strip->r->arenas+worker, sizeof(Raycaster));
+        *view = *strip->r;
+        view->worker = worker;
+        profile_begin_frame(&view->profile);
+#if PERFCOUNT
+        /* The counters only count the thread that opened them. */
+        if(worker) view->profile.counters = NULL;
+#endif
+        strip->views[worker] = view;
+    }
+    _render_strip(view, _wall_passes+strip->pass, strip->x1, strip->x2);
+}
+
+/* Give r an arena for each worker of r->jobs. */
+void _setup_arenas(Raycaster *r) {
+    Arena *arenas;
+    int i;
+    if(r->arena_num >= r->jobs->worker_num) return;
+    arenas = realloc(r->arenas, r->jobs->worker_num*sizeof(Arena));
+    if(!arenas){
+        fputs("[raycaster] Failed to allocate the arenas!", stderr);
+        exit(-1);
+    }
+    for(i=r->arena_num;i<r->jobs->worker_num;i++) arena_init(arenas+i, 0);
+    r->arenas = arenas;
+    r->arena_num = r->jobs->worker_num;
+}
+
+/* Render the strips of strip columns as jobs of r->jobs, which balances the
+ * strips that cost more, such as those facing a close wall. */
+void _render_strip_jobs(Raycaster *r, const WallPass *pass, int strip) {
+    JobSystem *jobs = r->jobs;
+    JobGroup group;
+    StripJob *strips;
+    StripJob *job;
+    Raycaster **views;
+    unsigned long start;
+    unsigned long busy[JOBS_WORKERS];
+    int n = (r->width+strip-1)/strip;
+    int i;
+    _setup_arenas(r);
+    strips = arena_alloc(r->arenas, n*sizeof(StripJob));
+    views = arena_alloc(r->arenas, jobs->worker_num*sizeof(Raycaster*));
+    for(i=0;i<jobs->worker_num;i++){
+        /* The workers are idle, so their arenas can be reset. */
+        if(i) arena_reset(r->arenas+i);
+        views[i] = NULL;
+        busy[i] = jobs->busy_us[i];
+    }
+    start = render_us(&RENDERER);
+    jobs_group_init(&group);
+    for(i=0;i<n;i++){
+        job = strips+i;
+        job->r = r;
+        job->pass = pass-_wall_passes;
+        job->x1 = i*strip;
+        job->x2 = job->x1+strip > r->width ? r->width : job->x1+strip;
+        job->views = views;
+        jobs_fork(jobs, 0, &group, _strip_job, job);
+    }
+    jobs_join(jobs, 0, &group);
+    for(i=0;i<jobs->worker_num;i++){
+        busy[i] = jobs->busy_us[i]-busy[i];
+        if(views[i]) profile_merge(&r->profile, &views[i]->profile);
+    }
+    profile_workers(&r->profile, jobs->worker_num, busy,
+                    render_us(&RENDERER)-start);
+}
+#endif
+
+/* Check if the walls of the last frame can be reused. */
+char _frame_unchanged(Raycaster *r, int features) {
+    FrameState *last = &r->last;
+    return last->valid && last->x == r->x && last->y == r->y &&
+           last->r == r->r && last->width == r->width &&
+           last->height == r->height && last->rays == r->rays &&
+           last->fov == r->fov && last->len == r->len &&
+           last->features == features && last->map == r->map &&
+           last->map_revision == r->map->revision &&
+           last->sprite_num == r->sprite_num;
+}
+
+void _mark_sprite_dirty(Raycaster *r, SpriteView *sprite) {
+    int start, end;
+    if(sprite->h <= 0) return;
+    start = sprite->screen_x-sprite->h/2;
+    end = sprite->screen_x+sprite->h/2;
+    if(start < 0) start = 0;
+    if(end > r->width) end = r->width;
+    if(start < end) memset(r->dirty+start, 1, end-start);
+}
+
+/* Redraw the columns covered by the sprites that changed since the last
+ * frame, before and after the change. */
+void _redraw_sprites(Raycaster *r, const WallPass *pass) {
+    int p;
+    int x, x1;
+    SpriteView *old, *sprite;
+    memset(r->dirty, 0, r->width);
+    for(p=0;p<r->sprite_num;p++){
+        old = r->last.sprites+p;
+        sprite = r->sprite_views+p;
+        if(old->x != sprite->x || old->y != sprite->y ||
+           old->texture != sprite->texture ||
+           old->visible != sprite->visible){
+            _mark_sprite_dirty(r, old);
+            _mark_sprite_dirty(r, sprite);
         }
     }
+    for(x=0;x<r->width;){
+        while(x < r->width && !r->dirty[x]) x++;
+        x1 = x;
+        while(x < r->width && r->dirty[x]) x++;
+        if(x1 < x) _draw_columns(r, pass, x1, x);
+    }
+}
+
+/* Remember what the frame was rendered from. */
+void _save_frame(Raycaster *r, int features) {
+    FrameState *last = &r->last;
+    SpriteView *sprites;
+    if(r->sprite_num > last->sprite_max){
+        sprites = realloc(last->sprites, r->sprite_num*sizeof(SpriteView));
+        if(!sprites){
+            fputs("[raycaster] Failed to allocate the sprite copy!", stderr);
+            exit(-1);
+        }
+        last->sprites = sprites;
+        last->sprite_max = r->sprite_num;
+    }
     if(r->sprite_num > 0){
-        for(p=0;p<r->sprite_num;p++){
-            sprite = r->sprites+p;
-            sprite->dist = SQRT(MUL(r->x-sprite->x, r->x-sprite->x)+
-                                MUL(r->y-sprite->y, r->y-sprite->y));
+        memcpy(last->sprites, r->sprite_views,
+               r->sprite_num*sizeof(SpriteView));
+    }
+    last->x = r->x;
+    last->y = r->y;
+    last->r = r->r;
+    last->width = r->width;
+    last->height = r->height;
+    last->rays = r->rays;
+    last->fov = r->fov;
+    last->len = r->len;
+    last->features = features;
+    last->map = r->map;
+    last->map_revision = r->map->revision;
+    last->sprite_num = r->sprite_num;
+    last->valid = 1;
+}
+
+/* Change the number of rays to get closer to r->target_ms, us being the time
+ * it took to render the last frame. The number of rays is always a divisor of
+ * the width, so that every column gets drawn. */
+void _adapt_rays(Raycaster *r, unsigned long us) {
+    int step = r->width/r->rays;
+    int new_step = step;
+    unsigned long target = r->target_ms*1000UL;
+    r->frame_us = (r->frame_us*3+us)/4;
+    if(r->adapt_wait > 0){
+        r->adapt_wait--;
+        return;
+    }
+    if(r->frame_us > target){
+        do{
+            new_step++;
+        }while(new_step < MAX_RAY_STEP && r->width%new_step);
+    }else if(r->frame_us < target*3/4){
+        do{
+            new_step--;
+        }while(new_step > 1 && r->width%new_step);
+    }
+    if(new_step != step && new_step >= 1 && new_step <= MAX_RAY_STEP &&
+       !(r->width%new_step)){
+        r->rays = r->width/new_step;
+        /* Let the average settle before changing it again. */
+        r->adapt_wait = 8;
+    }
+}
+
+/* Set the size of the frame from the detail mode. */
+void _set_frame_size(Raycaster *r) {
+    int width = render_get_width(&RENDERER);
+    int height = render_get_height(&RENDERER);
+    if(r->detail & DETAIL_HALF_X) width /= 2;
+    if(r->detail & DETAIL_HALF_Y) height /= 2;
+    if(width != r->width){
+        r->rays = r->rays*width/r->width;
+        if(r->rays < 1) r->rays = 1;
+        r->width = width;
+    }
+    r->height = height;
+}
+
+/* Redraw the map layer if the map changed. */
+void _update_map_layer(Raycaster *r) {
+    int i;
+    Pixel wall, empty;
+    Pixel *pixels;
+    MapLayer *layer = &r->map_layer;
+    /* Streamed maps are too big to be drawn entirely. */
+    if(!r->map->data) return;
+    if(layer->pixels && layer->map == r->map &&
+       layer->map_revision == r->map->revision) return;
+    if(layer->width*layer->height != r->map_width*r->map_height){
+        pixels = realloc(layer->pixels,
+                         r->map_width*r->map_height*sizeof(Pixel));
+        if(!pixels){
+            fputs("[raycaster] Failed to allocate the map layer!", stderr);
+            exit(-1);
         }
-        if(r->sprite_num > 1){
-            qsort(r->sprites, r->sprite_num, sizeof(Sprite),
-                  _raycaster_sort_sprites);
+        layer->pixels = pixels;
+    }
+    layer->width = r->map_width;
+    layer->height = r->map_height;
+    wall = render_color(0, 0, 0);
+    empty = render_color(255, 255, 255);
+    for(i=0;i<r->map_width*r->map_height;i++){
+        layer->pixels[i] = r->map->data[i] ? wall : empty;
+    }
+    layer->map = r->map;
+    layer->map_revision = r->map->revision;
+}
+
+/* Draw every step-th ray of r->columns from px, py, with scale pixels per
+ * cell. When clip is not 0, the rays are cut clip pixels away from px, py. */
+void _draw_map_rays(Raycaster *r, int px, int py, int scale, int step,
+                    int clip) {
+    int n;
+    int ex, ey;
+    fixed_t a;
+    fixed_t len;
+    fixed_t inc = TO_FIXED(r->fov)/r->rays;
+    for(n=0;n<r->rays;n+=step){
+        a = r->ray_base+n*inc;
+        len = r->columns[n].end.len;
+        if(r->fisheye_fix) len = MUL(len, DCOS(a-r->r));
+        ex = TO_INT(MUL(DCOS(a), len)*scale);
+        ey = TO_INT(MUL(DSIN(a), len)*scale);
+        if(clip && ABS(ex) > clip){
+            ey = ey*clip/ABS(ex);
+            ex = ex < 0 ? -clip : clip;
         }
-        for(p=0;p<r->sprite_num;p++){
-            sprite = r->sprites+p;
-            if(sprite->dist > TO_FIXED(r->len) || !sprite->visible){
-                sprite->screen_x = -1;
-                sprite->h = 0;
-                continue;
-            }
-            /* Calculate the position of the sprite on screen. */
-            a = datan2(sprite->y-r->y, sprite->x-r->x);
-            if(a < 0) a += TO_FIXED(360);
-            tmp = r->r+TO_FIXED(r->fov)/2-a;
-            tmp = tmp;
-            if(a > TO_FIXED(270) && r->r < TO_FIXED(90)) tmp += TO_FIXED(360);
-            if(r->r > TO_FIXED(270) && a < TO_FIXED(90)) tmp -= TO_FIXED(360);
-            x = r->width-TO_INT(tmp/r->fov*r->width);
-            sprite->screen_x = x;
-            h = TO_INT(DIV(TO_FIXED(r->height),
-                           (sprite->dist ? sprite->dist : 1)));
-            no_clip_h = h;
-            sprite->h = h;
-            if(h > r->height) h = r->height;
-            inc = TO_FIXED(TEX_WIDTH(sprite->texture))/no_clip_h;
-            if(x+no_clip_h/2 >= 0 && x-no_clip_h/2 < r->width){
-                for(t=0,i=x-no_clip_h/2;i<x+no_clip_h/2;i++,t++){
-                    if(i >= 0 && i < r->width){
-                        if(r->zbuffer[i] > sprite->dist){
-                            render_texvline(&RENDERER, sprite->texture,
-                                            r->height/2-h/2, r->height/2+h/2,
-                                            r->height/2-no_clip_h/2,
-                                            r->height/2+no_clip_h/2, i,
-                                            TO_INT(t*inc),
-                                            (255-TO_INT(sprite->dist/r->len*
-                                             255)));
-                        }
-                    }
-                }
-            }
+        if(clip && ABS(ey) > clip){
+            ex = ex*clip/ABS(ey);
+            ey = ey < 0 ? -clip : clip;
         }
+        render_line(&RENDERER, px, py, px+ex, py+ey, 0, 255, 0);
     }
 }
 
-RayEnd raycaster_raycast(Raycaster *r, fixed_t x1, fixed_t y1, fixed_t x2,
-                         fixed_t y2) {
+void raycaster_render_map(Raycaster *r) {
+    int x;
+    int ox, oy;
+    int width = render_get_width(&RENDERER);
+    int height = render_get_height(&RENDERER);
+    int map_w = r->map_width*r->scale;
+    int map_h = r->map_height*r->scale;
+    MapLayer *layer = &r->map_layer;
+    /* The map is drawn over the last frame. */
+    r->last.valid = 0;
+    _update_map_layer(r);
+    /* Keep the player on screen when the map doesn't fit on it. */
+    ox = oy = 0;
+    if(map_w > width){
+        ox = width/2-TO_INT(r->x*r->scale);
+        if(ox > 0) ox = 0;
+        if(ox < width-map_w) ox = width-map_w;
+    }
+    if(map_h > height){
+        oy = height/2-TO_INT(r->y*r->scale);
+        if(oy > 0) oy = 0;
+        if(oy < height-map_h) oy = height-map_h;
+    }
+    render_clear(&RENDERER, 0);
+    if(r->map->data){
+        render_blit(&RENDERER, layer->pixels, layer->width, layer->height,
+                    ox, oy, r->scale, 0, 0, width, height);
+    }
+    /* The rays are cast like in the wall pass, so that they can be reused
+     * when turning. */
+    profile_begin_frame(&r->profile);
+    _update_chunks(r);
+    _setup_rays(r);
+    _cast_columns(r, 0, r->rays);
+    _draw_map_rays(r, ox+TO_INT(r->x*r->scale), oy+TO_INT(r->y*r->scale),
+                   r->scale, 1, 0);
+    for(x=0;x<r->sprite_num;x++){
+        render_set_pixel(&RENDERER, ox+TO_INT(r->sprites[x].x*r->scale),
+                         oy+TO_INT(r->sprites[x].y*r->scale), 0, 0, 255);
+    }
+    render_line(&RENDERER, ox+TO_INT(r->x*r->scale),
+                oy+TO_INT(r->y*r->scale),
+                ox+TO_INT((r->x+DCOS(r->r))*r->scale),
+                oy+TO_INT((r->y+DSIN(r->r))*r->scale), 255, 0, 0);
+}
+
+/* Draw the minimap over the frame, from the rays of the wall pass. */
+void _render_minimap(Raycaster *r) {
+    int size = MINIMAP_CELLS*r->minimap;
+    int x = render_get_width(&RENDERER)-size-MINIMAP_MARGIN;
+    int y = MINIMAP_MARGIN;
+    int px = x+size/2;
+    int py = y+size/2;
+    int step = r->rays/MINIMAP_RAYS;
+    MapLayer *layer = &r->map_layer;
+    _update_map_layer(r);
+    render_rect(&RENDERER, x, y, size, size, 255, 255, 255);
+    if(r->map->data){
+        render_blit(&RENDERER, layer->pixels, layer->width, layer->height,
+                    px-TO_INT(r->x*r->minimap), py-TO_INT(r->y*r->minimap),
+                    r->minimap, x, y, size, size);
+    }
+    _draw_map_rays(r, px, py, r->minimap, step > 1 ? step : 1, size/2-1);
+    render_line(&RENDERER, px, py, px+TO_INT(DCOS(r->r)*r->minimap),
+                py+TO_INT(DSIN(r->r)*r->minimap), 255, 0, 0);
+}
+
+void raycaster_render_world(Raycaster *r) {
+    unsigned long frame_start;
+    int x;
+    int step;
+    int unit;
+    int strip;
+    int features;
+    const WallPass *pass;
+    frame_start = render_us(&RENDERER);
+    arena_reset(r->arenas);
+    while(r->r < 0) r->r += TO_FIXED(360);
+    while(r->r > TO_FIXED(360)) r->r -= TO_FIXED(360);
+    _set_frame_size(r);
+    /* Select the wall pass once per frame. */
+    pass = _wall_passes+((r->texture != 0) | (r->fisheye_fix != 0)<<1 |
+                         (r->rays < r->width)<<2);
+    r->profile.variant = pass->name;
+    profile_begin_frame(&r->profile);
+    _update_chunks(r);
+    _setup_rays(r);
+    if(r->floor && (r->map->floor || r->map->ceiling)) _setup_spans(r);
+    profile_start(&r->profile, PROFILE_SPRITES, render_us(&RENDERER));
+    _project_sprites(r);
+    profile_stop(&r->profile, PROFILE_SPRITES, render_us(&RENDERER));
+    features = (pass-_wall_passes) | (r->floor != 0)<<3 |
+               (r->gbuffer != NULL)<<4 |
+               (r->gbuffer && r->gbuffer->no_color)<<5;
+    /* The low detail modes scale the frame up in place, so it can't be
+     * reused. */
+    if(r->incremental && !r->detail && _frame_unchanged(r, features)){
+        _redraw_sprites(r, pass);
+    }else{
+        /* Render the screen strip by strip, so that the part of the screen
+         * and of the buffers that is being worked on stays in the cache. A
+         * strip always contains whole rays and whole depth tiles. */
+        step = r->width/r->rays;
+        unit = step/_gcd(step, DEPTH_TILE)*DEPTH_TILE;
+        strip = (r->strip_width+unit-1)/unit*unit;
+        if(strip < 1) strip = r->width;
+#if JOBS
+        if(r->jobs && r->map->data){
+            _render_strip_jobs(r, pass, strip);
+        }else
+#endif
+        for(x=0;x<r->width;x+=strip){
+            _render_strip(r, pass, x, x+strip > r->width ? r->width :
+                          x+strip);
+        }
+    }
+    if(r->incremental && !r->detail) _save_frame(r, features);
+    else r->last.valid = 0;
+    profile_end_frame(&r->profile);
+    if(!r->gbuffer || !r->gbuffer->no_color){
+        if(r->detail) render_upscale(&RENDERER, r->width, r->height);
+        if(r->minimap) _render_minimap(r);
+    }
+    r->profile.rays = r->rays;
+    r->profile.width = r->width;
+    r->profile.height = r->height;
+    if(r->target_ms){
+        _adapt_rays(r, render_us(&RENDERER)-frame_start);
+    }
+}
+
+/* The DDA of raycaster_raycast, only reading map. The ray starts at x1, y1
+ * and goes toward increasing x if right and increasing y if down. steplen is
+ * the length of the ray between two edges of the cells along each axis. */
+RayEnd _raycast_walk(Map *map, int len, fixed_t x1, fixed_t y1, char right,
+                     char down, Vector2 steplen) {
     int px = TO_INT(x1);
     int py = TO_INT(y1);
-    fixed_t tmp;
     RayEnd end;
     Vector2 rays;
-    Vector2 raystep;
-    Vector2 steplen;
     Vector2 start;
-    tmp = ABS(x2-x1);
-    if(!tmp) tmp++;
-    raystep.x = DIV((y2-y1), tmp);
-    steplen.x = SQRT(MUL(raystep.x, raystep.x)+TO_FIXED(1));
-    tmp = ABS(y2-y1);
-    if(!tmp) tmp++;
-    raystep.y = DIV((x2-x1), tmp);
-    steplen.y = SQRT(MUL(raystep.y, raystep.y)+TO_FIXED(1));
     end.hit = 0;
+    end.cx = px;
+    end.cy = py;
     /* Calculate start */
-    if(x1 < x2){
+    if(right){
         start.x = TO_FIXED(1)-(x1-FLOOR(x1));
     }else{
         start.x = x1-FLOOR(x1);
     }
-    if(y1 < y2){
+    if(down){
         start.y = TO_FIXED(1)-(y1-FLOOR(y1));
     }else{
         start.y = y1-FLOOR(y1);
@@ -277,21 +1168,21 @@ RayEnd raycaster_raycast(Raycaster *r, fixed_t x1, fixed_t y1, fixed_t x2,
         end.len = rays.y;
         end.x_axis_hit = 0;
     }
-    while(end.len < TO_FIXED(r->len)){
+    while(end.len < TO_FIXED(len)){
         /*rect(px*SCALE, py*SCALE, SCALE, SCALE, 127, 127, 255);*/
         if(rays.x < rays.y){
-            px += x1 < x2 ? 1 : -1;
+            px += right ? 1 : -1;
             rays.x += steplen.x;
             end.x_axis_hit = 0;
         }else{
-            py += y1 < y2 ? 1 : -1;
+            py += down ? 1 : -1;
             rays.y += steplen.y;
             end.x_axis_hit = 1;
         }
-        if(px >= 0 && px < r->map_width && py >= 0 && py < r->map_height){
+        if(px >= 0 && px < map->width && py >= 0 && py < map->height){
             end.cx = px;
             end.cy = py;
-            if(r->map->data[py*r->map_width+px]){
+            if(MAP_TILE(map, px, py)){
                 end.hit = 1;
                 break;
             }
@@ -309,3 +1200,89 @@ RayEnd raycaster_raycast(Raycaster *r, fixed_t x1, fixed_t y1, fixed_t x2,
     }
     return end;
 }
+
+/* Cast a ray from x1, y1 to x2, y2, only reading map. */
+RayEnd _raycast(Map *map, int len, fixed_t x1, fixed_t y1, fixed_t x2,
+                fixed_t y2) {
+    fixed_t tmp;
+    Vector2 raystep;
+    Vector2 steplen;
+    tmp = ABS(x2-x1);
+    if(!tmp) tmp++;
+    raystep.x = DIV((y2-y1), tmp);
+    steplen.x = SQRT(MUL(raystep.x, raystep.x)+TO_FIXED(1));
+    tmp = ABS(y2-y1);
+    if(!tmp) tmp++;
+    raystep.y = DIV((x2-x1), tmp);
+    steplen.y = SQRT(MUL(raystep.y, raystep.y)+TO_FIXED(1));
+    return _raycast_walk(map, len, x1, y1, x1 < x2, y1 < y2, steplen);
+}
+
+/* The length of a ray between two edges of the cells along an axis, d being
+ * the component of its unit vector along it. */
+fixed_t _scan_step(fixed_t d) {
+    d = ABS(d);
+    /* Parallel to the edges, the ray never crosses one. This stays small
+     * enough to be multiplied by a fraction of a cell. */
+    if(!d) return FIXED_MAX>>PRECISION;
+    return DIV(TO_FIXED(1), d);
+}
+
+RayEnd raycaster_raycast(Raycaster *r, fixed_t x1, fixed_t y1, fixed_t x2,
+                         fixed_t y2) {
+    return _raycast(r->map, r->len, x1, y1, x2, y2);
+}
+
+void raycaster_scan(Map *map, fixed_t x, fixed_t y, fixed_t a, fixed_t arc,
+                    int n, int len, int mode, fixed_t *dist, ScanHit *hits) {
+    int i;
+    int cx = TO_INT(x), cy = TO_INT(y);
+    /* The angle of the ray i, a-arc/2+arc*i/n, is stepped from one ray to the
+     * next with the quotient and the remainder of arc/n, instead of dividing
+     * for each ray. */
+    fixed_t ray_a = a-arc/2;
+    fixed_t step, rest;
+    fixed_t acc = 0;
+    fixed_t c, s;
+    Vector2 steplen;
+    RayEnd end;
+    if(n <= 0) return;
+    step = arc/n;
+    rest = arc%n;
+    linit();
+    for(i=0;i<n;i++){
+        /* The rays are set up from their unit vector, which takes a division
+         * per axis where raycaster_raycast needs a division and a square root
+         * to get the same lengths from the end of the ray. */
+        c = DCOS(ray_a);
+        s = DSIN(ray_a);
+        steplen.x = _scan_step(c);
+        steplen.y = _scan_step(s);
+        end = _raycast_walk(map, len, x, y, c > 0, s > 0, steplen);
+        if(dist){
+            if(!end.hit){
+                dist[i] = TO_FIXED(len);
+            }else if(mode == SCAN_PERPENDICULAR){
+                dist[i] = MUL(end.len, DCOS(ray_a-a));
+                /* Behind the plane of the scan. */
+                if(dist[i] < 0) dist[i] = 0;
+            }else{
+                dist[i] = end.len;
+            }
+        }
+        if(hits){
+            hits[i].cx = end.cx;
+            hits[i].cy = end.cy;
+            hits[i].face = _hit_face(&end, cx, cy);
+        }
+        ray_a += step;
+        acc += rest;
+        if(acc >= n){
+            acc -= n;
+            ray_a++;
+        }else if(acc <= -n){
+            acc += n;
+            ray_a--;
+        }
+    }
+}
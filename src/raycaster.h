@@ -39,6 +39,43 @@
 #include <render.h>
 #include <texture.h>
 #include <map.h>
+#include <profile.h>
+#include <arena.h>
+
+#if JOBS
+#include <jobs.h>
+#endif
+
+/* The floor and the ceiling are drawn with spans of SPAN_STEP pixels, the
+ * texture coordinates being stepped linearly between the two ends. */
+#define SPAN_STEP 16
+
+/* Low detail modes (Raycaster.detail), the frame is rendered at half the
+ * width and/or height and then scaled up. */
+enum {
+    DETAIL_HALF_X = 1,
+    DETAIL_HALF_Y = 2
+};
+
+/* With Raycaster.adaptive, one ray every ADAPTIVE_STEP rays is cast first, and
+ * the rays in between are only cast when needed. */
+#define ADAPTIVE_STEP 8
+
+/* The dynamic resolution uses at most one ray every MAX_RAY_STEP columns. */
+#define MAX_RAY_STEP 8
+
+/* Number of columns covered by each tile of the coarse depth buffer. */
+#define DEPTH_TILE 16
+
+/* Default width of the strips of columns the screen is rendered in. */
+#define STRIP_WIDTH 32
+
+/* The minimap shows MINIMAP_CELLS by MINIMAP_CELLS cells around the player, and
+ * MINIMAP_RAYS of the rays of the wall pass, MINIMAP_MARGIN pixels from the top
+ * right corner of the screen. */
+#define MINIMAP_CELLS 16
+#define MINIMAP_RAYS 32
+#define MINIMAP_MARGIN 8
 
 typedef struct {
     fixed_t x, y;
@@ -52,6 +89,102 @@ typedef struct {
     char x_axis_hit;
 } RayEnd;
 
+/* The face of a cell hit by a ray of raycaster_scan. North is toward y = 0
+ * and west toward x = 0. */
+enum {
+    FACE_NONE,
+    FACE_NORTH,
+    FACE_SOUTH,
+    FACE_WEST,
+    FACE_EAST
+};
+
+/* The distances returned by raycaster_scan. */
+enum {
+    SCAN_EUCLIDEAN,
+    SCAN_PERPENDICULAR /* Along the direction of the scan, like the z-buffer. */
+};
+
+typedef struct {
+    int cx, cy; /* The cell that was hit. */
+    char face;
+} ScanHit;
+
+/* The result of a ray of the wall pass. */
+typedef struct {
+    RayEnd end;
+    fixed_t u; /* Where the ray hit the face of the cell, between 0 and 1. */
+} Column;
+
+/* The rays of the previous frames, stored by absolute angle for the rotation
+ * reuse: the ray that has the angle k*fov/rays is stored at k%rays. They are
+ * valid as long as the camera does not move. */
+typedef struct {
+    Column *columns;
+    long *keys; /* The k of each stored ray, -1 if there is none. */
+    fixed_t x, y;
+    int fov;
+    int rays;
+    int len;
+    Map *map;
+    unsigned int map_revision;
+} RayCache;
+
+/* The walls of the map with one pixel per cell, redrawn when the map
+ * changes. */
+typedef struct {
+    Pixel *pixels;
+    int width, height;
+    Map *map;
+    unsigned int map_revision;
+} MapLayer;
+
+/* Planes filled by raycaster_render_world along with the colors, e.g. to
+ * label the frames. Any plane can be NULL. With DETAIL_HALF_X, only the first
+ * half of the columns is filled. */
+typedef struct {
+    /* One entry per column, the distance is in the z-buffer. */
+    unsigned char *tile; /* The tile that was hit, 0 if none. */
+    unsigned char *face; /* FACE_NONE if nothing was hit. */
+    fixed_t *u; /* Where the ray hit the face, between 0 and 1. */
+    /* One entry per pixel of the screen, row by row: 1 + the index in
+     * r->sprites of the sprite drawn there, 0 where there is none. */
+    unsigned short *sprite;
+    /* Only fill the planes and the z-buffer, without drawing anything. */
+    char no_color;
+} GBuffer;
+
+/* A sprite as seen by a raycaster. The sprites of the map are only read, so
+ * that several raycasters can share a map. */
+typedef struct {
+    int index; /* Index of the sprite in r->sprites. */
+    /* Copied from the sprite when projecting it. */
+    fixed_t x, y;
+    Texture *texture;
+    char visible;
+    fixed_t dist;
+    int screen_x;
+    int h; /* without clipping. */
+} SpriteView;
+
+/* What the last frame was rendered from, to know what changed since then in
+ * the incremental mode. */
+typedef struct {
+    char valid;
+    fixed_t x, y, r;
+    int width, height;
+    int rays;
+    int fov;
+    int len;
+    int features;
+    Map *map;
+    unsigned int map_revision;
+    /* A copy of the sprites as they were sorted and projected. */
+    SpriteView *sprites;
+    int sprite_num;
+    int sprite_max;
+} FrameState;
+
 typedef struct {
     /* Settings */
     int fov;
@@ -62,29 +195,104 @@ typedef struct {
     int rotspeed;
     int width;
     int height;
+    /* Frame time targeted by the dynamic resolution, or 0. The frames are
+     * timed with render_us, which needs libprof on the CG: without a free
+     * timer there, the time stays 0 and the ray count is never lowered. */
+    int target_ms;
+    int strip_width; /* Width of the strips, 0 to render in a single strip. */
+    int minimap; /* Size of a cell of the minimap in pixels, 0 to hide it. */
     /* Features */
     char texture;
     char fisheye_fix;
+    char floor;
+    char detail;
+    char adaptive;
+    /* Only redraw the columns covered by sprites that changed when the view
+     * and the map did not change. The renderer has to keep the content of
+     * the screen between frames. */
+    char incremental;
+    /* Reuse the rays of the previous frames when the camera only turns. The
+     * angles of the rays are snapped to multiples of fov/rays. */
+    char reuse_rays;
     /* Data */
     fixed_t *zbuffer;
+    GBuffer *gbuffer; /* NULL by default. */
+    Column *columns; /* The result of each ray. */
+    int *wall_h; /* Half of the clipped height of the wall in each column. */
+    Vector2 *span_dirs;
+    /* The nearest and the farthest wall in each DEPTH_TILE columns. */
+    fixed_t *depth_min;
+    fixed_t *depth_max;
+    MapLayer map_layer;
     Map *map;
     int map_width;
     int map_height;
     Sprite *sprites;
     int sprite_num;
+    /* The sprites from the farthest to the nearest, in the order of the last
+     * frame until they are sorted again. */
+    SpriteView *sprite_views;
+    int sprite_view_num;
+    int sprite_view_max;
     /* View */
     fixed_t x;
     fixed_t y;
     fixed_t r;
+    /* The renderer created by raycaster_init. */
     Renderer renderer;
+    /* Where the frames are drawn. */
+    Renderer *target;
+    /* Dynamic resolution */
+    unsigned long frame_us;
+    int adapt_wait;
+    /* Angle of the first ray of the frame. */
+    fixed_t ray_base;
+    /* Rotation reuse */
+    RayCache ray_cache;
+    long ray_k; /* The k of the first ray of the frame. */
+    /* Incremental rendering */
+    FrameState last;
+    unsigned char *dirty; /* The columns that need to be redrawn. */
+    /* The transient data of a frame comes from arenas, which are reset at
+     * the start of each frame: arenas[0] for the thread that renders and
+     * arenas[i] for the worker i of jobs. worker is the arena of this
+     * raycaster. */
+    Arena *arenas;
+    int arena_num;
+    int worker;
+#if JOBS
+    /* Share the strips of the frames between the workers of jobs if it isn't
+     * NULL (the default), rendering from the worker 0. Streamed maps are
+     * always rendered by a single thread. */
+    JobSystem *jobs;
+#endif
+    /* Stats */
+    Profile profile;
 } Raycaster;
 
+/* Several raycasters can render at the same time from different threads,
+ * each one into its own target, as long as they don't modify the map that
+ * they share (streamed maps can't be shared, see chunkmap.h). */
+
 void raycaster_init(Raycaster *r, int width, int height, char *title,
                     Map *map, fixed_t x, fixed_t y, fixed_t a,
                     fixed_t *zbuffer);
 
+/* Initialize a raycaster drawing into target, a renderer that was already
+ * initialized, instead of creating its own. The first call to
+ * raycaster_init or raycaster_init_target must not happen while another
+ * thread is rendering. */
+void raycaster_init_target(Raycaster *r, Renderer *target, Map *map,
+                           fixed_t x, fixed_t y, fixed_t a, fixed_t *zbuffer);
+
+void raycaster_free(Raycaster *r);
+
 void raycaster_set_sprites(Raycaster *r, Sprite *sprites, int sprite_num);
 
+/* Use another map, or the same map after its size or its sprites changed. The
+ * caches built from the map are only rebuilt if its revision changed. */
+void raycaster_set_map(Raycaster *r, Map *map);
+
 void raycaster_render_map(Raycaster *r);
 
 void raycaster_render_world(Raycaster *r);
@@ -94,6 +302,19 @@ RayEnd raycaster_raycast(Raycaster *r, fixed_t x1, fixed_t y1, fixed_t x2,
 
 void raycaster_render_map(Raycaster *r);
 
-
+/* Cast n rays from x, y over arc degrees centered on the angle a, like a
+ * lidar, without rendering anything. The ray i has the angle
+ * a-arc/2+arc*i/n, so an arc of 360 covers the full circle. The distance of
+ * each ray, len if it hit nothing within len cells, is stored in dist and the
+ * cell and the face it hit in hits, any of them can be NULL. The map is only
+ * read, with the same rules as rendering. The rays are set up from their
+ * direction rather than from their end, so the distances may differ from
+ * raycaster_raycast by rounding, and a ray grazing a corner may hit the cell
+ * on the other side of it. Nothing is cast if n <= 0. With
+ * SCAN_PERPENDICULAR, the rays more than 90 degrees away from a are behind
+ * the plane of the scan and get a distance of 0, so that mode is only meant
+ * for arcs under 180 degrees. */
+void raycaster_scan(Map *map, fixed_t x, fixed_t y, fixed_t a, fixed_t arc,
+                    int n, int len, int mode, fixed_t *dist, ScanHit *hits);
 
 #endif
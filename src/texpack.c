@@ -0,0 +1,266 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* mmap, open and fstat are POSIX. */
+#define _POSIX_C_SOURCE 200112L
+
+#include <texpack.h>
+
+#if TEXPACK
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define HEADER_SIZE 16
+#define ENTRY_SIZE 64
+#define TEXTURE_MAX 4096
+
+unsigned long _texpack_u32(const unsigned char *p) {
+    return (unsigned long)p[0] | (unsigned long)p[1]<<8 |
+           (unsigned long)p[2]<<16 | (unsigned long)p[3]<<24;
+}
+
+/* 1 if the RGBA8888 texels of the file are laid out like the ones of the
+ * renderer. */
+int _texpack_native(void) {
+    union {
+        unsigned int i;
+        unsigned char c[4];
+    } u;
+    u.i = 1;
+    return sizeof(unsigned int) == 4 && u.c[0] == 1;
+}
+
+int _texpack_bpp(int format) {
+    switch(format){
+        case TEXPACK_RGBA8888:
+            return 4;
+        case TEXPACK_RGB565:
+            return 2;
+        case TEXPACK_INDEXED:
+            return 1;
+    }
+    return 0;
+}
+
+/* Number of texels in the levels of a texture. */
+unsigned long _texpack_texels(int width, int height, int level_num) {
+    int i;
+    unsigned long n = 0;
+    for(i=0;i<level_num;i++){
+        n += (unsigned long)(width>>i > 1 ? width>>i : 1)*
+             (height>>i > 1 ? height>>i : 1);
+    }
+    return n;
+}
+
+int _texpack_error(TexPack *pack, const char *path, const char *error) {
+    fprintf(stderr, "[texpack] %s: %s\n", path, error);
+    texpack_close(pack);
+    return -1;
+}
+
+int texpack_open(TexPack *pack, const char *path) {
+    int fd;
+    struct stat st;
+    unsigned char *mem;
+    unsigned char *p;
+    unsigned long i;
+    unsigned long count, index;
+    unsigned long offset, size;
+    TexPackEntry *entry;
+    memset(pack, 0, sizeof(TexPack));
+    fd = open(path, O_RDONLY);
+    if(fd < 0) return _texpack_error(pack, path, "Failed to open the file!");
+    if(fstat(fd, &st) || st.st_size < HEADER_SIZE){
+        close(fd);
+        return _texpack_error(pack, path, "Not a texture pack!");
+    }
+    mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mem == MAP_FAILED){
+        return _texpack_error(pack, path, "Failed to map the file!");
+    }
+    pack->mem = mem;
+    pack->size = st.st_size;
+    if(memcmp(mem, "RTEX", 4)){
+        return _texpack_error(pack, path, "Not a texture pack!");
+    }
+    if(_texpack_u32(mem+4) != TEXPACK_VERSION){
+        return _texpack_error(pack, path, "Unsupported version!");
+    }
+    count = _texpack_u32(mem+8);
+    index = _texpack_u32(mem+12);
+    if(index > pack->size || count > (pack->size-index)/ENTRY_SIZE){
+        return _texpack_error(pack, path, "Invalid header!");
+    }
+    pack->entries = malloc((count ? count : 1)*sizeof(TexPackEntry));
+    if(!pack->entries){
+        return _texpack_error(pack, path, "Failed to allocate the index!");
+    }
+    for(i=0;i<count;i++){
+        p = mem+index+i*ENTRY_SIZE;
+        entry = pack->entries+i;
+        /* Counted now, so that texpack_close frees what was allocated. */
+        pack->entry_num++;
+        entry->levels = NULL;
+        entry->decoded = NULL;
+        entry->name = (const char*)p;
+        entry->width = _texpack_u32(p+32);
+        entry->height = _texpack_u32(p+36);
+        entry->format = _texpack_u32(p+40);
+        entry->level_num = _texpack_u32(p+44);
+        if(_texpack_u32(p+32) < 1 || _texpack_u32(p+32) > TEXTURE_MAX ||
+           _texpack_u32(p+36) < 1 || _texpack_u32(p+36) > TEXTURE_MAX ||
+           !_texpack_bpp(_texpack_u32(p+40)) ||
+           _texpack_u32(p+44) < 1 ||
+           _texpack_u32(p+44) > TEXPACK_LEVELS_MAX){
+            return _texpack_error(pack, path, "Invalid texture!");
+        }
+        offset = _texpack_u32(p+48);
+        size = _texpack_u32(p+52);
+        if(offset%TEXPACK_ALIGN || offset > pack->size ||
+           size > pack->size-offset ||
+           size != _texpack_texels(entry->width, entry->height,
+                                   entry->level_num)*
+                   _texpack_bpp(entry->format)){
+            return _texpack_error(pack, path, "Invalid texels!");
+        }
+        entry->texels = mem+offset;
+        entry->palette = NULL;
+        entry->color_num = 0;
+        if(entry->format == TEXPACK_INDEXED){
+            offset = _texpack_u32(p+56);
+            size = _texpack_u32(p+60);
+            if(size < 1 || size > 256 || offset > pack->size ||
+               size*4 > pack->size-offset){
+                return _texpack_error(pack, path, "Invalid palette!");
+            }
+            entry->palette = mem+offset;
+            entry->color_num = size;
+        }
+    }
+    return 0;
+}
+
+void texpack_close(TexPack *pack) {
+    int i;
+    for(i=0;i<pack->entry_num;i++){
+        free(pack->entries[i].levels);
+        free(pack->entries[i].decoded);
+    }
+    free(pack->entries);
+    if(pack->mem) munmap(pack->mem, pack->size);
+    memset(pack, 0, sizeof(TexPack));
+}
+
+int texpack_find(TexPack *pack, const char *name) {
+    int i;
+    for(i=0;i<pack->entry_num;i++){
+        if(!strncmp(pack->entries[i].name, name, TEXPACK_NAME_MAX)) return i;
+    }
+    return -1;
+}
+
+/* Convert the texels of an entry to the layout of the renderer. */
+void _texpack_decode(TexPackEntry *entry, unsigned int *out, unsigned long n) {
+    unsigned long i;
+    unsigned long c;
+    unsigned int r, g, b;
+    const unsigned char *p = entry->texels;
+    for(i=0;i<n;i++){
+        switch(entry->format){
+            case TEXPACK_RGBA8888:
+                out[i] = _texpack_u32(p+i*4);
+                break;
+            case TEXPACK_RGB565:
+                c = p[i*2] | p[i*2+1]<<8;
+                r = c>>11;
+                g = (c>>5)&0x3F;
+                b = c&0x1F;
+                out[i] = (r<<3 | r>>2)<<24 | (g<<2 | g>>4)<<16 |
+                         (b<<3 | b>>2)<<8 | 0xFF;
+                break;
+            case TEXPACK_INDEXED:
+                /* Indices out of the palette are transparent. */
+                out[i] = p[i] < entry->color_num ?
+                         _texpack_u32(entry->palette+p[i]*4) : 0;
+                break;
+        }
+    }
+}
+
+Texture *texpack_texture(TexPack *pack, int id, int level) {
+    int i;
+    unsigned long n;
+    const unsigned int *texels;
+    TexPackEntry *entry;
+    if(id < 0 || id >= pack->entry_num) return NULL;
+    entry = pack->entries+id;
+    if(level < 0 || level >= entry->level_num) return NULL;
+    if(entry->levels) return entry->levels+level;
+    n = _texpack_texels(entry->width, entry->height, entry->level_num);
+    entry->levels = malloc(entry->level_num*sizeof(Texture));
+    if(!entry->levels){
+        fputs("[texpack] Failed to allocate the levels!", stderr);
+        exit(-1);
+    }
+    if(entry->format == TEXPACK_RGBA8888 && _texpack_native()){
+        texels = (const unsigned int*)entry->texels;
+    }else{
+        entry->decoded = malloc(n*sizeof(unsigned int));
+        if(!entry->decoded){
+            fputs("[texpack] Failed to allocate the texels!", stderr);
+            exit(-1);
+        }
+        _texpack_decode(entry, entry->decoded, n);
+        texels = entry->decoded;
+    }
+    for(i=0;i<entry->level_num;i++){
+        entry->levels[i].data = texels;
+        entry->levels[i].width = entry->width>>i > 1 ? entry->width>>i : 1;
+        entry->levels[i].height = entry->height>>i > 1 ?
+                                  entry->height>>i : 1;
+        entry->levels[i].extradata = NULL;
+        texels += entry->levels[i].width*entry->levels[i].height;
+    }
+    return entry->levels+level;
+}
+
+#endif
@@ -0,0 +1,126 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TEXPACK_H
+#define TEXPACK_H
+
+#include <config.h>
+#include <texture.h>
+
+#include <stddef.h>
+
+/* Texture packs, to load the textures from a single file instead of building
+ * them into the executable.
+ *
+ * All the integers are stored in little endian. A file starts with a header:
+ *
+ * offset size
+ * 0      4    magic, "RTEX"
+ * 4      4    version, TEXPACK_VERSION
+ * 8      4    number of textures
+ * 12     4    offset of the index
+ *
+ * The index contains 64 bytes for each texture:
+ *
+ * offset size
+ * 0      32   name, padded with zeros
+ * 32     4    width
+ * 36     4    height
+ * 40     4    format
+ * 44     4    number of levels, 1 for a texture without mipmaps
+ * 48     4    offset of the texels, a multiple of TEXPACK_ALIGN
+ * 52     4    size of the texels
+ * 56     4    offset of the palette
+ * 60     4    number of colors in the palette
+ *
+ * The levels are stored one after the other, level n being width>>n by
+ * height>>n texels (at least 1 by 1). The formats are:
+ *
+ * TEXPACK_RGBA8888 4 bytes per texel, 0xRRGGBBAA, like the textures
+ *                  generated by texgen.py.
+ * TEXPACK_RGB565   2 bytes per texel, opaque.
+ * TEXPACK_INDEXED  1 byte per texel, an index in the palette, which is stored
+ *                  as TEXPACK_RGBA8888.
+ *
+ * The pack is mapped into memory, so the page cache decides which textures
+ * stay in memory. RGBA8888 textures are used directly from the mapping when
+ * it is the layout of the renderer, the others are decoded when they are
+ * first requested. */
+
+#define TEXPACK_VERSION 1
+#define TEXPACK_NAME_MAX 32
+#define TEXPACK_ALIGN 64
+#define TEXPACK_LEVELS_MAX 16
+
+enum {
+    TEXPACK_RGBA8888 = 1,
+    TEXPACK_RGB565,
+    TEXPACK_INDEXED
+};
+
+typedef struct {
+    const char *name; /* Not always terminated by a zero. */
+    int width, height;
+    int format;
+    int level_num;
+    const unsigned char *texels;
+    const unsigned char *palette;
+    int color_num;
+    /* The levels that were requested, NULL until then. */
+    Texture *levels;
+    unsigned int *decoded;
+} TexPackEntry;
+
+typedef struct TexPack {
+    TexPackEntry *entries;
+    int entry_num;
+    void *mem;
+    size_t size;
+} TexPack;
+
+/* Load the texture pack at path. Returns 0 on success, prints an error and
+ * returns -1 on failure. */
+int texpack_open(TexPack *pack, const char *path);
+
+void texpack_close(TexPack *pack);
+
+/* Returns the id of the texture called name, or -1. */
+int texpack_find(TexPack *pack, const char *name);
+
+/* Get a level of a texture, decoding it if needed. The textures stay valid
+ * until the pack is closed. Returns NULL if the texture or the level doesn't
+ * exist. */
+Texture *texpack_texture(TexPack *pack, int id, int level);
+
+#endif
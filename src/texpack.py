@@ -0,0 +1,143 @@
+"""
+A quick and dirty raycaster.
+texpack.py: generate a texture pack from images.
+by Mibi88
+
+This software is licensed under the BSD-3-Clause license:
+
+Copyright (c) 2024 Mibi88.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+    1. Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+    2. Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+    3. Neither the name of the copyright holder nor the names of its
+    contributors may be used to endorse or promote products derived from this
+    software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+"""
+
+from PIL import Image
+import sys
+import os
+import struct
+
+VERSION = 1
+NAME_MAX = 32
+ALIGN = 64
+LEVELS_MAX = 16
+
+RGBA8888, RGB565, INDEXED = range(1, 4)
+
+FORMATS = {"rgba8888": RGBA8888, "rgb565": RGB565, "indexed": INDEXED}
+
+if len(sys.argv) < 3:
+    sys.stderr.write("USAGE: texpack [OUTPUT] [[--format=FORMAT] [--mips] "
+                     "FILE]...\n"
+                     "FORMAT is rgba8888 (default), rgb565 or indexed. The "
+                     "options apply to the\nfiles that follow them.\n")
+    sys.exit(1)
+
+output = sys.argv[1]
+
+textures = []
+
+fmt = RGBA8888
+mips = False
+for i in sys.argv[2:]:
+    if i.startswith("--format="):
+        if i[9:] not in FORMATS:
+            sys.stderr.write(f"texpack: Unknown format: {i[9:]}!\n")
+            sys.exit(1)
+        fmt = FORMATS[i[9:]]
+    elif i == "--mips":
+        mips = True
+    else:
+        textures.append((i, fmt, mips))
+
+def getlevels(img, mips):
+    levels = [img]
+    w, h = img.size
+    while mips and (w > 1 or h > 1) and len(levels) < LEVELS_MAX:
+        w, h = max(w//2, 1), max(h//2, 1)
+        levels.append(img.resize((w, h), Image.BOX))
+    return levels
+
+def getpixels(img):
+    w, h = img.size
+    for y in range(h):
+        for x in range(w):
+            yield img.getpixel((x, y))
+
+def rgba8888(levels):
+    out = bytearray()
+    for img in levels:
+        for pixel in getpixels(img):
+            out += struct.pack("<I", pixel[0]<<24|pixel[1]<<16|pixel[2]<<8|
+                                     pixel[3])
+    return bytes(out), b"", 0
+
+def rgb565(levels):
+    out = bytearray()
+    for img in levels:
+        for pixel in getpixels(img):
+            out += struct.pack("<H", (pixel[0]>>3)<<11|(pixel[1]>>2)<<5|
+                                     pixel[2]>>3)
+    return bytes(out), b"", 0
+
+def indexed(levels):
+    colors = []
+    out = bytearray()
+    for img in levels:
+        for pixel in getpixels(img):
+            if pixel not in colors:
+                if len(colors) >= 256:
+                    sys.stderr.write("texpack: More than 256 colors!\n")
+                    sys.exit(1)
+                colors.append(pixel)
+            out.append(colors.index(pixel))
+    palette = b"".join(struct.pack("<I", c[0]<<24|c[1]<<16|c[2]<<8|c[3])
+                       for c in colors)
+    return bytes(out), palette, len(colors)
+
+ENCODERS = {RGBA8888: rgba8888, RGB565: rgb565, INDEXED: indexed}
+
+def align(data):
+    return data+b"\0"*(-len(data)%ALIGN)
+
+out = b"RTEX"+struct.pack("<III", VERSION, len(textures), 16)
+payload = align(out+b"\0"*(64*len(textures)))
+for file, fmt, mips in textures:
+    name = os.path.splitext(os.path.basename(file))[0].lower()
+    if len(name.encode()) >= NAME_MAX:
+        sys.stderr.write(f"texpack: Texture name too long: {name}!\n")
+        sys.exit(1)
+    img = Image.open(file).convert("RGBA")
+    levels = getlevels(img, mips)
+    texels, palette, colors = ENCODERS[fmt](levels)
+    offset = len(payload)
+    payload = align(payload+texels)
+    palette_offset = len(payload) if colors else 0
+    payload = align(payload+palette)
+    out += name.encode().ljust(NAME_MAX, b"\0")
+    out += struct.pack("<IIIIIIII", img.size[0], img.size[1], fmt,
+                       len(levels), offset, len(texels), palette_offset,
+                       colors)
+payload = out+payload[len(out):]
+
+with open(output, "wb") as fp:
+    fp.write(payload)
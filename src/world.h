@@ -0,0 +1,139 @@
+/* A quick and dirty raycaster.
+ * by Mibi88
+ *
+ * This software is licensed under the BSD-3-Clause license:
+ *
+ * Copyright 2024 Mibi88
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from this
+ * software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Template for the wall pass of raycaster_render_world. This file is included
+ * several times by raycaster.c, once for each combination of the following
+ * macros, to generate a wall pass without any per-column feature branches:
+ *
+ * WORLD_FUNC    the name of the generated function.
+ * WORLD_TEXTURE 1 to draw textured walls, 0 for flat shaded walls.
+ * WORLD_FISHEYE 1 to apply the fisheye fix.
+ * WORLD_WIDE    1 if a ray covers more than one column (r->rays < r->width).
+ *
+ * The generated function draws the columns x1 to x2 (excluded) from the rays
+ * stored in r->columns.
+ */
+
+void WORLD_FUNC(Raycaster *r, int x1, int x2) {
+    int n;
+    int p;
+#if WORLD_WIDE
+    int c;
+    int c1, c2;
+    int step = r->width/r->rays;
+#endif
+    int h;
+    int fog;
+    fixed_t len;
+    Column *col;
+#if WORLD_FISHEYE
+    fixed_t inc = TO_FIXED(r->fov)/r->rays;
+    fixed_t half_fov = TO_FIXED(r->fov)/2;
+#endif
+#if WORLD_TEXTURE
+    int no_clip_h;
+    int l;
+    Texture *tex;
+#endif
+#if WORLD_WIDE
+    for(n=x1/step,p=n*step;p<x2 && n<r->rays;n++,p+=step){
+        c1 = p < x1 ? x1-p : 0;
+        c2 = p+step > x2 ? x2-p : step;
+#else
+    for(n=x1,p=x1;p<x2;n++,p++){
+#endif
+        col = r->columns+n;
+        len = col->end.len;
+#if WORLD_WIDE
+        for(c=c1;c<c2;c++) r->zbuffer[p+c] = len;
+#else
+        r->zbuffer[p] = len;
+#endif
+        if(!col->end.hit){
+#if WORLD_WIDE
+            for(c=c1;c<c2;c++){
+                r->wall_h[p+c] = 0;
+                render_vline(&RENDERER, 0, r->height, p+c, 0, 0, 0);
+            }
+#else
+            r->wall_h[p] = 0;
+            render_vline(&RENDERER, 0, r->height, p, 0, 0, 0);
+#endif
+            continue;
+        }
+#if WORLD_TEXTURE
+        tex = _get_tile_tex(r, col->end.cx, col->end.cy);
+        l = TO_INT(col->u*TEX_WIDTH(tex));
+#endif
+#if WORLD_FISHEYE
+        len = MUL(len, DCOS(-half_fov+n*inc));
+#endif
+        h = TO_INT(DIV(TO_FIXED(r->height), (len ? len : 1)));
+#if WORLD_TEXTURE
+        no_clip_h = h;
+#endif
+        if(h > r->height) h = r->height;
+        fog = 255-TO_INT(len/r->len*255);
+#if WORLD_WIDE
+        for(c=c1;c<c2;c++){
+#define WORLD_X (p+c)
+#else
+#define WORLD_X p
+#endif
+            r->wall_h[WORLD_X] = h/2;
+#if NOCLEAR
+            render_vline(&RENDERER, 0, r->height/2-h/2, WORLD_X, 0, 0, 0);
+            render_vline(&RENDERER, r->height/2+h/2, r->height, WORLD_X, 0,
+                         0, 0);
+#endif
+#if WORLD_TEXTURE
+            render_texvline(&RENDERER, tex, r->height/2-h/2, r->height/2+h/2,
+                            r->height/2-no_clip_h/2, r->height/2+no_clip_h/2,
+                            WORLD_X, l, fog);
+#else
+            render_vline(&RENDERER, r->height/2-h/2, r->height/2+h/2, WORLD_X,
+                         fog*(!col->end.x_axis_hit), fog*col->end.x_axis_hit,
+                         0);
+#endif
+#undef WORLD_X
+#if WORLD_WIDE
+        }
+#endif
+    }
+}
+
+#undef WORLD_FUNC
+#undef WORLD_TEXTURE
+#undef WORLD_FISHEYE
+#undef WORLD_WIDE